@@ -0,0 +1,304 @@
+/*
+ * AlsaSequencerInput.cpp file header.
+ *
+ * Chris Laguna
+ */
+
+#include "AlsaSequencerInput.h"
+#include "PaintProfiler.h"
+
+#if JUCE_LINUX
+
+#include <alsa/asoundlib.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/eventfd.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace {
+  int64 monotonicNanoseconds() {
+    timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (int64) t.tv_sec * 1000000000 + t.tv_nsec;
+  }
+}
+
+/***** Public members *****/
+
+AlsaSequencerInput::AlsaSequencerInput(MidiInputCallback& c) : Thread("ALSA sequencer input"),
+    callback(c), seq(nullptr), port(-1), queue(-1), realtime_priority(false), queue_start_ns(0),
+    fifo(RING_SIZE), wake_fd(-1), drain_thread(*this), num_events(0), latency_sum_us(0),
+    latency_sum_squares_us(0), latency_max_us(0), num_dropped(0) {}
+
+AlsaSequencerInput::~AlsaSequencerInput() {
+  stop();
+}
+
+bool AlsaSequencerInput::start(bool use_realtime_priority) {
+  stop();
+
+  if(snd_seq_open(&seq, "default", SND_SEQ_OPEN_INPUT, SND_SEQ_NONBLOCK) < 0) {
+    seq = nullptr;
+    return false;
+  }
+  snd_seq_set_client_name(seq, ProjectInfo::projectName);
+
+  port = snd_seq_create_simple_port(seq, "input",
+                                    SND_SEQ_PORT_CAP_WRITE | SND_SEQ_PORT_CAP_SUBS_WRITE,
+                                    SND_SEQ_PORT_TYPE_MIDI_GENERIC | SND_SEQ_PORT_TYPE_APPLICATION);
+  queue = snd_seq_alloc_queue(seq);
+  wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if(port < 0 || queue < 0 || wake_fd < 0) {
+    stop();
+    return false;
+  }
+
+  // Have the kernel stamp every incoming event with the queue's real time.
+  snd_seq_port_info_t* port_info;
+  snd_seq_port_info_alloca(&port_info);
+  snd_seq_get_port_info(seq, port, port_info);
+  snd_seq_port_info_set_timestamping(port_info, 1);
+  snd_seq_port_info_set_timestamp_real(port_info, 1);
+  snd_seq_port_info_set_timestamp_queue(port_info, queue);
+  snd_seq_set_port_info(seq, port, port_info);
+
+  snd_seq_start_queue(seq, queue, nullptr);
+  snd_seq_drain_output(seq);
+  queue_start_ns = monotonicNanoseconds();
+
+  num_events.store(0);
+  latency_sum_us.store(0);
+  latency_sum_squares_us.store(0);
+  latency_max_us.store(0);
+  num_dropped.store(0);
+
+  fifo.reset();
+  drain_thread.startThread();
+  realtime_priority = use_realtime_priority;
+  startThread();
+  return true;
+}
+
+void AlsaSequencerInput::stop() {
+  // Both threads wake up at least every POLL_TIMEOUT_MS to check whether they should exit.
+  stopThread(1000);
+  drain_thread.signalThreadShouldExit();
+  wakeDrainThread();
+  drain_thread.stopThread(1000);
+
+  if(wake_fd >= 0) {
+    close(wake_fd);
+  }
+  wake_fd = -1;
+
+  if(seq != nullptr) {
+    if(queue >= 0) {
+      snd_seq_free_queue(seq, queue);
+    }
+    if(port >= 0) {
+      snd_seq_delete_simple_port(seq, port);
+    }
+    snd_seq_close(seq);
+  }
+  seq = nullptr;
+  port = -1;
+  queue = -1;
+}
+
+bool AlsaSequencerInput::isRunning() const {
+  return isThreadRunning();
+}
+
+String AlsaSequencerInput::getPortAddress() const {
+  if(seq == nullptr) {
+    return String();
+  }
+  return String(snd_seq_client_id(seq)) + ":" + String(port);
+}
+
+AlsaSequencerInput::LatencyStats AlsaSequencerInput::getLatencyStats() const {
+  LatencyStats stats = { 0, 0.0, 0.0, 0.0 };
+  int64 count = num_events.load(std::memory_order_relaxed);
+  if(count == 0) {
+    return stats;
+  }
+
+  double sum = (double) latency_sum_us.load(std::memory_order_relaxed);
+  double sum_squares = (double) latency_sum_squares_us.load(std::memory_order_relaxed);
+  stats.num_events = (int) count;
+  stats.mean_us = sum / count;
+  stats.max_us = (double) latency_max_us.load(std::memory_order_relaxed);
+  stats.jitter_us = std::sqrt(jmax(0.0, sum_squares / count - stats.mean_us * stats.mean_us));
+  return stats;
+}
+
+/***** Private members *****/
+
+void AlsaSequencerInput::run() {
+  PaintProfiler::registerThread(getThreadName());
+  if(realtime_priority) {
+    sched_param param;
+    param.sched_priority = REALTIME_PRIORITY;
+    if(pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) != 0) {
+      // Needs CAP_SYS_NICE or an rtprio limit; carry on at normal priority.
+      DBG("AlsaSequencerInput: could not switch to SCHED_FIFO");
+    }
+  }
+
+  struct pollfd fds[4];
+  int num_fds = jmin(snd_seq_poll_descriptors_count(seq, POLLIN), 4);
+  snd_seq_poll_descriptors(seq, fds, num_fds, POLLIN);
+
+  while(!threadShouldExit()) {
+    if(poll(fds, num_fds, POLL_TIMEOUT_MS) > 0) {
+      readPendingEvents();
+    }
+  }
+}
+
+void AlsaSequencerInput::readPendingEvents() {
+  snd_seq_event_t* ev = nullptr;
+  bool pushed = false;
+
+  // With SND_SEQ_NONBLOCK this returns -EAGAIN once the kernel's buffer is empty.
+  int result;
+  while((result = snd_seq_event_input(seq, &ev)) >= 0 || result == -ENOSPC) {
+    if(result == -ENOSPC) {
+      // The kernel's input buffer overran; those events are gone.
+      num_dropped.fetch_add(1, std::memory_order_relaxed);
+      continue;
+    }
+
+    Event event;
+    if(!decode(*ev, &event)) {
+      continue;
+    }
+
+    double latency_seconds = 0.0;
+    recordLatency(*ev, &latency_seconds);
+
+    // Stamped with when the kernel received it.
+    event.timestamp = Time::getMillisecondCounterHiRes() * 0.001 - latency_seconds;
+
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite(1, start1, size1, start2, size2);
+    if(size1 == 0) {
+      // The drain thread has fallen a whole ring behind.
+      num_dropped.fetch_add(1, std::memory_order_relaxed);
+      continue;
+    }
+    ring[start1] = event;
+    fifo.finishedWrite(1);
+    pushed = true;
+  }
+
+  // One wake-up per batch, however many events it had.
+  if(pushed) {
+    wakeDrainThread();
+  }
+}
+
+void AlsaSequencerInput::wakeDrainThread() {
+  if(wake_fd >= 0) {
+    uint64_t one = 1;
+    ssize_t written = write(wake_fd, &one, sizeof(one));
+    ignoreUnused(written);
+  }
+}
+
+void AlsaSequencerInput::drainRing() {
+  int start1, size1, start2, size2;
+  fifo.prepareToRead(fifo.getNumReady(), start1, size1, start2, size2);
+  for(int i = 0; i < size1 + size2; i++) {
+    // Short messages are stored inline, so this doesn't allocate.
+    const Event& event = ring[i < size1 ? start1 + i : start2 + i - size1];
+    callback.handleIncomingMidiMessage(nullptr, MidiMessage(event.data, event.size, event.timestamp));
+  }
+  fifo.finishedRead(size1 + size2);
+}
+
+bool AlsaSequencerInput::decode(const snd_seq_event& ev, Event* out) {
+  uint8 channel = ev.data.note.channel & 0x0f;
+  switch(ev.type) {
+    case SND_SEQ_EVENT_NOTEON:
+      out->data[0] = 0x90 | channel;
+      out->data[1] = ev.data.note.note & 0x7f;
+      out->data[2] = ev.data.note.velocity & 0x7f;
+      out->size = 3;
+      return true;
+    case SND_SEQ_EVENT_NOTEOFF:
+      out->data[0] = 0x80 | channel;
+      out->data[1] = ev.data.note.note & 0x7f;
+      out->data[2] = ev.data.note.velocity & 0x7f;
+      out->size = 3;
+      return true;
+    case SND_SEQ_EVENT_KEYPRESS:
+      out->data[0] = 0xa0 | channel;
+      out->data[1] = ev.data.note.note & 0x7f;
+      out->data[2] = ev.data.note.velocity & 0x7f;
+      out->size = 3;
+      return true;
+    case SND_SEQ_EVENT_CONTROLLER:
+      out->data[0] = 0xb0 | (ev.data.control.channel & 0x0f);
+      out->data[1] = ev.data.control.param & 0x7f;
+      out->data[2] = ev.data.control.value & 0x7f;
+      out->size = 3;
+      return true;
+    case SND_SEQ_EVENT_PGMCHANGE:
+      out->data[0] = 0xc0 | (ev.data.control.channel & 0x0f);
+      out->data[1] = ev.data.control.value & 0x7f;
+      out->size = 2;
+      return true;
+    case SND_SEQ_EVENT_CHANPRESS:
+      out->data[0] = 0xd0 | (ev.data.control.channel & 0x0f);
+      out->data[1] = ev.data.control.value & 0x7f;
+      out->size = 2;
+      return true;
+    case SND_SEQ_EVENT_PITCHBEND: {
+      int value = ev.data.control.value + 8192;
+      out->data[0] = 0xe0 | (ev.data.control.channel & 0x0f);
+      out->data[1] = value & 0x7f;
+      out->data[2] = (value >> 7) & 0x7f;
+      out->size = 3;
+      return true;
+    }
+  }
+  return false;
+}
+
+void AlsaSequencerInput::DrainThread::run() {
+  struct pollfd fd;
+  fd.fd = owner.wake_fd;
+  fd.events = POLLIN;
+  fd.revents = 0;
+  while(!threadShouldExit()) {
+    if(poll(&fd, 1, POLL_TIMEOUT_MS) > 0) {
+      // Reading an eventfd resets its count, so one read takes every wake-up since the last.
+      uint64_t count;
+      ssize_t result = read(owner.wake_fd, &count, sizeof(count));
+      ignoreUnused(result);
+    }
+    owner.drainRing();
+  }
+}
+
+void AlsaSequencerInput::recordLatency(const snd_seq_event& ev, double* latency_seconds) {
+  if((ev.flags & SND_SEQ_TIME_STAMP_MASK) != SND_SEQ_TIME_STAMP_REAL) {
+    return;
+  }
+
+  int64 kernel_ns = (int64) ev.time.time.tv_sec * 1000000000 + ev.time.time.tv_nsec;
+  int64 latency_us = jmax((int64) 0, (monotonicNanoseconds() - queue_start_ns - kernel_ns) / 1000);
+  *latency_seconds = latency_us * 1.0e-6;
+
+  num_events.store(num_events.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  latency_sum_us.store(latency_sum_us.load(std::memory_order_relaxed) + latency_us, std::memory_order_relaxed);
+  latency_sum_squares_us.store(latency_sum_squares_us.load(std::memory_order_relaxed) + latency_us * latency_us,
+                               std::memory_order_relaxed);
+  if(latency_us > latency_max_us.load(std::memory_order_relaxed)) {
+    latency_max_us.store(latency_us, std::memory_order_relaxed);
+  }
+}
+
+#endif  // JUCE_LINUX
@@ -0,0 +1,111 @@
+/*
+ * AlsaSequencerInput: Linux-only MIDI input that reads the ALSA sequencer directly, instead of
+ * going through JUCE's MidiInput.
+ *
+ * Chris Laguna
+ */
+
+#ifndef ALSASEQUENCERINPUT_H_INCLUDED
+#define ALSASEQUENCERINPUT_H_INCLUDED
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include <atomic>
+
+#if JUCE_LINUX
+
+struct _snd_seq;
+struct snd_seq_event;
+
+/*
+ * Creates a sequencer client with one writable port, which other clients (hardware ports,
+ * aplaymidi, a virtual keyboard, ...) connect to with aconnect. A dedicated reader thread,
+ * optionally running with SCHED_FIFO priority, waits for events, decodes and timestamps them into
+ * a preallocated ring, and never locks or allocates. After each batch it wakes a normal priority
+ * drain thread with a single write to an eventfd; the drain thread empties the ring and hands
+ * each message to |callback|, the same way JUCE's MidiInput calls back on its own thread. So
+ * whatever |callback| does (sending MIDI thru, posting to the message thread) can't hold up the
+ * reader, and there is only the one hop between the two threads.
+ *
+ * The port asks the kernel to timestamp events when they arrive, so the time between that and the
+ * reader thread picking the event up can be measured (see getLatencyStats).
+ */
+class AlsaSequencerInput : private Thread {
+public:
+  // |callback| is called on the drain thread, with a null source.
+  AlsaSequencerInput(MidiInputCallback& callback);
+  ~AlsaSequencerInput();
+
+  // Opens the sequencer and starts the reader thread. Returns false if the sequencer can't be opened.
+  bool start(bool use_realtime_priority);
+  void stop();
+  bool isRunning() const;
+
+  // "client:port", for connecting to with aconnect.
+  String getPortAddress() const;
+
+  // Kernel timestamp to reader thread wake-up, over every event since start().
+  struct LatencyStats {
+    int num_events;
+    double mean_us;
+    double max_us;
+    double jitter_us;  // Standard deviation.
+  };
+  LatencyStats getLatencyStats() const;
+
+private:
+  struct Event {
+    uint8 data[3];
+    int size;
+    double timestamp;  // Seconds, on the same clock as Time::getMillisecondCounterHiRes.
+  };
+
+  // Empties the ring whenever the reader signals |wake_fd|.
+  class DrainThread : public Thread {
+  public:
+    explicit DrainThread(AlsaSequencerInput& o) : Thread("ALSA sequencer drain"), owner(o) {}
+    void run() override;
+
+  private:
+    AlsaSequencerInput& owner;
+
+    JUCE_DECLARE_NON_COPYABLE (DrainThread)
+  };
+
+  static const int RING_SIZE = 1024;
+  static const int REALTIME_PRIORITY = 70;  // SCHED_FIFO priority, out of 1-99.
+  static const int POLL_TIMEOUT_MS = 100;   // How often both threads check whether they should exit.
+
+  MidiInputCallback& callback;
+  _snd_seq* seq;
+  int port;
+  int queue;
+  bool realtime_priority;
+  int64 queue_start_ns;  // CLOCK_MONOTONIC time the queue was started. Kernel timestamps count from here.
+
+  // Written only by the reader thread, read only by the drain thread.
+  AbstractFifo fifo;
+  Event ring[RING_SIZE];
+  int wake_fd;  // eventfd the reader writes to after pushing events.
+  DrainThread drain_thread;
+
+  // Latency totals. start() clears them before starting the reader, which then is the only writer.
+  std::atomic<int64> num_events;
+  std::atomic<int64> latency_sum_us;
+  std::atomic<int64> latency_sum_squares_us;
+  std::atomic<int64> latency_max_us;
+  std::atomic<int> num_dropped;  // Lost to a kernel overrun or a full ring.
+
+  void run() override;
+
+  void readPendingEvents();
+  void wakeDrainThread();
+  void drainRing();
+  static bool decode(const snd_seq_event& ev, Event* out);
+  void recordLatency(const snd_seq_event& ev, double* latency_seconds);
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AlsaSequencerInput)
+};
+
+#endif  // JUCE_LINUX
+
+#endif  // ALSASEQUENCERINPUT_H_INCLUDED
@@ -0,0 +1,243 @@
+/*
+ * BatchRenderer.cpp file header.
+ *
+ * Chris Laguna
+ */
+
+#include "BatchRenderer.h"
+#include "GrandStaffComponent.h"
+#include <iostream>
+
+/***** RenderJob *****/
+
+// Renders a single MIDI file. Runs on one of the pool's threads.
+class BatchRenderer::RenderJob : public ThreadPoolJob {
+public:
+  RenderJob(BatchRenderer& o, const File& f) : ThreadPoolJob(f.getFileName()), owner(o), midi_file(f) {}
+
+  JobStatus runJob() override {
+    if(renderFile()) {
+      ++owner.num_files_done;
+    }
+    else {
+      ++owner.num_files_failed;
+      std::cerr << "Failed to render " << midi_file.getFullPathName() << std::endl;
+    }
+    if(--owner.num_jobs_remaining == 0) {
+      owner.all_jobs_done.signal();
+    }
+    return jobHasFinished;
+  }
+
+private:
+  BatchRenderer& owner;
+  File midi_file;
+
+  bool renderFile() {
+    FileInputStream stream(midi_file);
+    MidiFile midi;
+    if(stream.failedToOpen() || !midi.readFrom(stream)) {
+      return false;
+    }
+    midi.convertTimestampTicksToSeconds();
+
+    // Merge all the tracks so that both hands end up on the same grand staff.
+    MidiMessageSequence events;
+    for(int track = 0; track < midi.getNumTracks(); track++) {
+      events.addSequence(*midi.getTrack(track), 0.0, 0.0, 1.0e9);
+    }
+
+    File frame_dir = owner.output_dir.getChildFile(midi_file.getFileNameWithoutExtension());
+    if(!frame_dir.createDirectory()) {
+      return false;
+    }
+
+    GrandStaffComponent staff;
+    staff.setSize(FRAME_WIDTH, FRAME_HEIGHT);
+    Image frame(Image::RGB, FRAME_WIDTH, FRAME_HEIGHT, false);
+
+    // A pitch can be held on several channels at once; only the first note-on and the last
+    // note-off change what the staff shows.
+    int held_count[128] = { 0 };
+    int num_held = 0;
+    int frame_number = 0;
+
+    int event_idx = 0;
+    while(event_idx < events.getNumEvents()) {
+      if(shouldExit()) {
+        return false;
+      }
+
+      // Everything that happens at the same time is one chord change.
+      double time = events.getEventPointer(event_idx)->message.getTimeStamp();
+      bool changed = false;
+      for(; event_idx < events.getNumEvents(); event_idx++) {
+        const MidiMessage& message = events.getEventPointer(event_idx)->message;
+        if(message.getTimeStamp() != time) {
+          break;
+        }
+
+        int note = message.getNoteNumber();
+        if(message.isNoteOn()) {
+          if(held_count[note]++ == 0) {
+            staff.addNote(note);
+            num_held++;
+            changed = true;
+          }
+        }
+        else if(message.isNoteOff() && held_count[note] > 0) {
+          if(--held_count[note] == 0) {
+            staff.removeNote(note);
+            num_held--;
+            changed = true;
+          }
+        }
+      }
+
+      if(changed && num_held > 0) {
+        frame_number++;
+        if(!writeFrame(staff, frame, frame_dir, frame_number)) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  bool writeFrame(GrandStaffComponent& staff, Image& frame, const File& frame_dir, int frame_number) {
+    {
+      Graphics g(frame);
+      staff.paint(g);
+    }
+
+    File frame_file = frame_dir.getChildFile("chord_" + String(frame_number).paddedLeft('0', 4) + ".png");
+    frame_file.deleteFile();
+    FileOutputStream out(frame_file);
+    PNGImageFormat png;
+    if(out.failedToOpen() || !png.writeImageToStream(frame, out)) {
+      return false;
+    }
+
+    ++owner.num_frames_written;
+    return true;
+  }
+
+  JUCE_DECLARE_NON_COPYABLE (RenderJob)
+};
+
+/***** Public members *****/
+
+BatchRenderer::BatchRenderer(const File& in, const File& out, int threads)
+    : input_dir(in), output_dir(out), num_threads(threads) {}
+
+BatchRenderer::~BatchRenderer() {}
+
+int BatchRenderer::run() {
+  if(!findFiles()) {
+    return 1;
+  }
+
+  std::cout << "Rendering " << midi_files.size() << " files on " << num_threads << " threads" << std::endl;
+  double seconds = renderFiles(num_threads);
+
+  int done = num_files_done.get();
+  std::cout << done << " files, " << num_frames_written.get() << " frames in "
+            << String(seconds, 2) << " s ("
+            << String(seconds > 0.0 ? done / seconds : 0.0, 2) << " files/s)" << std::endl;
+
+  return num_files_failed.get() == 0 ? 0 : 1;
+}
+
+int BatchRenderer::runScaling() {
+  if(!findFiles()) {
+    return 1;
+  }
+
+  std::cout << "Rendering " << midi_files.size() << " files on 1 to " << num_threads << " threads" << std::endl;
+  double single_thread_rate = 0.0;
+  for(int threads = 1; ; threads = jmin(threads * 2, num_threads)) {
+    double seconds = renderFiles(threads);
+    if(num_files_failed.get() > 0) {
+      return 1;
+    }
+
+    double rate = seconds > 0.0 ? num_files_done.get() / seconds : 0.0;
+    if(threads == 1) {
+      single_thread_rate = rate;
+    }
+    std::cout << threads << " threads: " << String(rate, 2) << " files/s ("
+              << String(single_thread_rate > 0.0 ? rate / single_thread_rate : 0.0, 2) << "x)" << std::endl;
+
+    if(threads == num_threads) {
+      return 0;
+    }
+  }
+}
+
+bool BatchRenderer::runFromCommandLine(const StringArray& args, int* exit_code) {
+  int batch_idx = args.indexOf("--batch");
+  if(batch_idx < 0) {
+    return false;
+  }
+
+  if(batch_idx + 2 >= args.size()) {
+    std::cerr << "Usage: --batch <midi_dir> <output_dir> [--threads N] [--scaling]" << std::endl;
+    *exit_code = 1;
+    return true;
+  }
+
+  int threads = SystemStats::getNumCpus();
+  int threads_idx = args.indexOf("--threads");
+  if(threads_idx >= 0 && threads_idx + 1 < args.size()) {
+    threads = jmax(1, args[threads_idx + 1].getIntValue());
+  }
+
+  File cwd = File::getCurrentWorkingDirectory();
+  BatchRenderer renderer(cwd.getChildFile(args[batch_idx + 1].unquoted()),
+                         cwd.getChildFile(args[batch_idx + 2].unquoted()),
+                         threads);
+  *exit_code = args.contains("--scaling") ? renderer.runScaling() : renderer.run();
+  return true;
+}
+
+/***** Private members *****/
+
+bool BatchRenderer::findFiles() {
+  if(!input_dir.isDirectory()) {
+    std::cerr << "Not a directory: " << input_dir.getFullPathName() << std::endl;
+    return false;
+  }
+  if(!output_dir.createDirectory()) {
+    std::cerr << "Could not create " << output_dir.getFullPathName() << std::endl;
+    return false;
+  }
+
+  midi_files.clear();
+  input_dir.findChildFiles(midi_files, File::findFiles, false, "*.mid;*.midi");
+  midi_files.sort();
+  return true;
+}
+
+double BatchRenderer::renderFiles(int threads) {
+  num_files_done = 0;
+  num_files_failed = 0;
+  num_frames_written = 0;
+  num_jobs_remaining = midi_files.size();
+  all_jobs_done.reset();
+
+  // Keeps the staff images loaded between jobs. Otherwise they are decoded again whenever no job
+  // happens to be holding on to them, which is between every file with one thread.
+  SharedResourcePointer<StaffGlyphs> glyphs;
+
+  double start_time = Time::getMillisecondCounterHiRes();
+  {
+    ThreadPool pool(threads);
+    for(int i = 0; i < midi_files.size(); i++) {
+      pool.addJob(new RenderJob(*this, midi_files[i]), true);
+    }
+    if(midi_files.size() > 0) {
+      all_jobs_done.wait();
+    }
+  }
+  return (Time::getMillisecondCounterHiRes() - start_time) / 1000.0;
+}
@@ -0,0 +1,66 @@
+/*
+ * BatchRenderer: Command-line mode that renders every chord change in a directory of MIDI files
+ * to PNG images, without opening a window.
+ *
+ * Chris Laguna
+ */
+
+#ifndef BATCHRENDERER_H_INCLUDED
+#define BATCHRENDERER_H_INCLUDED
+
+#include "../JuceLibraryCode/JuceHeader.h"
+
+/*
+ * Each MIDI file is one job on a ThreadPool with one thread per core. Idle threads pull the next
+ * file from the pool's queue, so long files don't hold up short ones. Every job owns its own
+ * GrandStaffComponent, but the staff images are shared (see StaffGlyphs). Frames are written to
+ * disk as soon as they are drawn, so memory use doesn't grow with the length of a file.
+ *
+ * Output for <input_dir>/song.mid goes to <output_dir>/song/chord_0001.png, chord_0002.png, ...
+ */
+class BatchRenderer {
+public:
+  BatchRenderer(const File& input_dir, const File& output_dir, int num_threads);
+  ~BatchRenderer();
+
+  // Renders all the files, prints a summary and returns the process exit code.
+  int run();
+
+  // Renders all the files with 1, 2, 4, ... up to |num_threads| threads and prints the files per
+  // second and the speedup over one thread for each. Returns the process exit code.
+  int runScaling();
+
+  /*
+   * Entry point from the application. Handles:
+   *   --batch <midi_dir> <output_dir> [--threads N] [--scaling]
+   * Returns true if the command line asked for batch mode (in which case |exit_code| is set).
+   */
+  static bool runFromCommandLine(const StringArray& args, int* exit_code);
+
+  // Size of each rendered frame. Matches the size of the staff in the main window.
+  static const int FRAME_WIDTH = 832;
+  static const int FRAME_HEIGHT = 250;
+
+private:
+  class RenderJob;
+
+  File input_dir;
+  File output_dir;
+  int num_threads;
+  Array<File> midi_files;
+
+  // Updated by the worker threads.
+  Atomic<int> num_files_done;
+  Atomic<int> num_files_failed;
+  Atomic<int> num_frames_written;
+  Atomic<int> num_jobs_remaining;
+  WaitableEvent all_jobs_done;  // Signalled by the job that brings |num_jobs_remaining| to 0.
+
+  bool findFiles();
+  // Renders |midi_files| on |threads| threads and returns the time it took, in seconds.
+  double renderFiles(int threads);
+
+  JUCE_DECLARE_NON_COPYABLE (BatchRenderer)
+};
+
+#endif  // BATCHRENDERER_H_INCLUDED
@@ -0,0 +1,75 @@
+/*
+ * ClefGeometry: Where each clef puts notes on a staff, as compile-time policies for
+ * GrandStaffComponent.
+ *
+ * Chris Laguna
+ */
+
+#ifndef CLEFGEOMETRY_H_INCLUDED
+#define CLEFGEOMETRY_H_INCLUDED
+
+/*
+ * The clefs a staff can use. Picking one selects the matching policy below; the drawing code is
+ * instantiated once per policy, so nothing inside it checks which clef it is drawing.
+ */
+enum ClefType {
+  TREBLE_CLEF = 0,
+  BASS_CLEF,
+  ALTO_CLEF,        // Viola.
+  TENOR_CLEF,       // Cello, bassoon and trombone in their upper range.
+  TREBLE_8VA_CLEF,  // Sounds an octave above the treble clef.
+  BASS_8VB_CLEF,    // Sounds an octave below the bass clef.
+  NUM_CLEF_TYPES
+};
+
+// The symbol a clef is drawn with. The staff image comes with a G clef on top and an F clef below.
+enum ClefGlyph {
+  G_CLEF,
+  F_CLEF,
+  C_CLEF
+};
+
+/*
+ * Every clef is described by the pitch on the second space from the bottom of the staff (A4 for
+ * treble, C3 for bass). Measuring everything in lines/spaces ("letters") from that reference means
+ * the staff lines and ledger lines are in the same place for every clef; only the reference pitch
+ * and the clef symbol change.
+ */
+template <ClefType Type, int ReferencePitch, ClefGlyph Glyph, int GlyphLine, int OctaveShift>
+struct ClefPolicy {
+  static constexpr ClefType TYPE = Type;
+  static constexpr int REFERENCE_PITCH = ReferencePitch;
+
+  // Staff lines, in letters from the reference.
+  static constexpr int TOP_LINE = 5;
+  static constexpr int BOTTOM_LINE = -3;
+
+  // The first ledger line on either side of the staff.
+  static constexpr int FIRST_LEDGER_ABOVE = TOP_LINE + 2;
+  static constexpr int FIRST_LEDGER_BELOW = BOTTOM_LINE - 2;
+
+  // The clef symbol, and the line it marks (G4 for a G clef, F3 for F, C4 for C), in letters from
+  // the reference.
+  static constexpr ClefGlyph GLYPH = Glyph;
+  static constexpr int GLYPH_LINE = GlyphLine;
+
+  // +1 for an "8" above the symbol, -1 for one below.
+  static constexpr int OCTAVE_SHIFT = OctaveShift;
+
+  // Number of ledger lines a note |distance| letters from the reference needs.
+  static constexpr int getNumberLedgerLines(int distance) {
+    return distance >= FIRST_LEDGER_ABOVE ? (distance - TOP_LINE) / 2
+         : distance <= FIRST_LEDGER_BELOW ? (BOTTOM_LINE - distance) / 2
+         : 0;
+  }
+};
+
+//                 Type             Reference  Glyph  Glyph line  Octave
+typedef ClefPolicy<TREBLE_CLEF,     69, G_CLEF, -1,  0> TrebleClef;     // A4, G clef on G4.
+typedef ClefPolicy<BASS_CLEF,       48, F_CLEF,  3,  0> BassClef;       // C3, F clef on F3.
+typedef ClefPolicy<ALTO_CLEF,       59, C_CLEF,  1,  0> AltoClef;       // B3, C clef on the middle line.
+typedef ClefPolicy<TENOR_CLEF,      55, C_CLEF,  3,  0> TenorClef;      // G3, C clef on the fourth line.
+typedef ClefPolicy<TREBLE_8VA_CLEF, 81, G_CLEF, -1,  1> Treble8vaClef;  // A5.
+typedef ClefPolicy<BASS_8VB_CLEF,   36, F_CLEF,  3, -1> Bass8vbClef;    // C2.
+
+#endif  // CLEFGEOMETRY_H_INCLUDED
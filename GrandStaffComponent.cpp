@@ -1,451 +1,738 @@
-/*
- * GrandStaffComponent.cpp file header.
- *
- * Chris Laguna
- */
-
-#include "../JuceLibraryCode/JuceHeader.h"
-#include "GrandStaffComponent.h"
-#include "MainContentComponent.h"
-
-/***** Public members *****/
-
-GrandStaffComponent::GrandStaffComponent() : bottom_treble_note(0), bottom_bass_note(0) {
-  
-  // Convert images from binary data to Images. 
-  grand_staff_image = ImageFileFormat::loadFrom(BinaryData::Grand_Staff_png, BinaryData::Grand_Staff_pngSize);
-  int actual_height = grand_staff_image.getHeight();
-  int actual_width = grand_staff_image.getWidth();
-  float scale_factor = GRAND_STAFF_HEIGHT / (float) actual_height;
-  grand_staff_image = grand_staff_image.rescaled(actual_width * scale_factor, actual_height * scale_factor);
-  
-  whole_note_image = ImageFileFormat::loadFrom(BinaryData::Whole_Note_png, BinaryData::Whole_Note_pngSize);
-  actual_height = whole_note_image.getHeight();
-  actual_width = whole_note_image.getWidth();
-  scale_factor = WHOLE_NOTE_HEIGHT / (float) actual_height;
-  whole_note_image = whole_note_image.rescaled(actual_width * scale_factor, actual_height * scale_factor);
- 
-  flat_image = ImageFileFormat::loadFrom(BinaryData::Flat_png, BinaryData::Flat_pngSize);
-  actual_height = flat_image.getHeight();
-  actual_width = flat_image.getWidth();
-  scale_factor = FLAT_HEIGHT / (float) actual_height;
-  flat_image = flat_image.rescaled(actual_width * scale_factor, actual_height * scale_factor);
- 
-  sharp_image = ImageFileFormat::loadFrom(BinaryData::Sharp_png, BinaryData::Sharp_pngSize);
-  actual_height = sharp_image.getHeight();
-  actual_width = sharp_image.getWidth();
-  scale_factor = SHARP_HEIGHT / (float) actual_height;
-  sharp_image = sharp_image.rescaled(actual_width * scale_factor, actual_height * scale_factor);
-}
-
-GrandStaffComponent::~GrandStaffComponent() {
-  notes_to_draw.clear();
-}
-
-void GrandStaffComponent::paint (Graphics& g) {
-  g.fillAll (Colours::white);
-  
-  // Draw the staff.
-  g.drawImageAt(grand_staff_image, 0, STAFF_Y_OFFSET);
-  
-  vector<int> note_ys;
-  // Draw each note individually.
-  int prev_note = 0;
-  bool prev_note_offset = false;
-  for(int note_idx = 0; note_idx < notes_to_draw.size(); note_idx++) {
-    int cur_note = notes_to_draw[note_idx];
-    
-    // Clear out the previous note when switching clefs.
-    if(prev_note != 0 && drawOnTrebleClef(prev_note) != drawOnTrebleClef(cur_note)) {
-      prev_note = 0;
-      prev_note_offset = false;
-    }
-    
-    prev_note_offset = drawNote(g, cur_note, prev_note, prev_note_offset, &note_ys);
-    prev_note = cur_note;
-  }
-
-  int prev_accidental = 0;
-  int cur_x = NOTE_X;
-  for(int note_idx = notes_to_draw.size() - 1; note_idx >= 0; note_idx--) {
-    int cur_note = notes_to_draw[note_idx];
-    
-    if(hasAccidental(cur_note)) {
-      if(prev_accidental == 0
-         || abs(getLetterDistance(cur_note, prev_accidental)) > 4
-         || drawOnTrebleClef(prev_accidental) != drawOnTrebleClef(cur_note)
-        ) {
-        prev_accidental = cur_note;
-        cur_x = NOTE_X;
-      }
-      else {
-        cur_x += ACCIDENTAL_X_DELTA;
-      }
-
-      drawAccidental(g, cur_x, note_ys[note_idx]);
-    }
-  }
-  
-}
-
-void GrandStaffComponent::resized() {}
-
-void GrandStaffComponent::addNote(int midi_pitch) {
-  // Only add notes within the range of the keyboard.
-  if(midi_pitch < MainContentComponent::getMinNote() || midi_pitch > MainContentComponent::getMaxNote()) {
-    return;
-  }
-  
-  notes_to_draw.push_back(midi_pitch);
-  std::sort(notes_to_draw.begin(), notes_to_draw.end());
-
-  // Update bottom note.
-  if(drawOnTrebleClef(midi_pitch)) {
-    if(midi_pitch < bottom_treble_note || bottom_treble_note == 0) {
-      bottom_treble_note = midi_pitch;
-    }
-  }
-  else {
-    if(midi_pitch < bottom_bass_note || bottom_bass_note == 0) {
-      bottom_bass_note = midi_pitch;
-    }
-  }
-  repaint();
-}
-
-void GrandStaffComponent::removeNote(int midi_pitch) {
-  // Only remove notes within the range of the keyboard.
-  if(midi_pitch < MainContentComponent::getMinNote() || midi_pitch > MainContentComponent::getMaxNote()) {
-    return;
-  }
-  
-  std::vector<int>::iterator it = find(notes_to_draw.begin(), notes_to_draw.end(), midi_pitch);
-  if(it != notes_to_draw.end()) {
-    notes_to_draw.erase(it);
-  }
-  std::sort(notes_to_draw.begin(), notes_to_draw.end());
-  
-  // Update bottom note.
-  updateBottomNotes();
-  repaint();
-}
-
-void GrandStaffComponent::setAccidentalMode(AccidentalMode at) {
-  accidental_mode = at;
-}
-
-/***** Private Members *****/
-
-void GrandStaffComponent::updateBottomNotes() {
-  bottom_treble_note = 0;
-  bottom_bass_note = 0;
-  
-  for(int i = 0; i < notes_to_draw.size(); i++) {
-    int cur_note = notes_to_draw[i];
-    if(drawOnTrebleClef(cur_note)) {
-      if(cur_note < bottom_treble_note || bottom_treble_note == 0) {
-        bottom_treble_note = cur_note;
-      }
-    }
-    else {
-      if(cur_note < bottom_bass_note || bottom_bass_note == 0) {
-        bottom_bass_note = cur_note;
-      }
-    }
-  }
-}
-
-bool GrandStaffComponent::drawOnTrebleClef(int note) {
-  // Middle C and above go on the treble clef.
-  return note >= 60;
-}
-
-bool GrandStaffComponent::drawNote(Graphics& g, int note, int prev_note, bool prev_note_offset, vector<int>* note_ys) {
-  bool did_offset = false;
-  if(drawOnTrebleClef(note)) {
-    did_offset = drawNoteOnTrebleClef(g, note, prev_note, prev_note_offset, note_ys);
-  }
-  else {
-    did_offset = drawNoteOnBassClef(g, note, prev_note, prev_note_offset, note_ys);
-  }
-  return did_offset;
-}
-
-bool GrandStaffComponent::drawNoteOnTrebleClef(Graphics& g, int note, int prev_note, bool prev_note_offset, vector<int>* note_ys) {
-  bool did_offset = false;
-  int note_x = NOTE_X;
-  int distance = getLetterDistance(note, 69);
-  
-  // Checking to add an x-offset to the note.
-  if(prev_note > 0) {
-    if(getLetterDistance(note, prev_note) < 2 && !prev_note_offset) {
-      note_x = note_x + X_LINE_DELTA;
-      did_offset = true;
-    }
-  }
-  
-  int note_y = MIDI_69_Y - (distance * NOTE_DELTA_Y);
-  g.drawImageAt(whole_note_image, note_x, note_y);
-  
-  note_ys->push_back(note_y);
-  
-  int num_ledger_lines = getNumberLedgerLines(distance);
-  drawLedgerLinesOnTrebleClef(g, num_ledger_lines, distance > 0);
-  return did_offset;
-}
-
-bool GrandStaffComponent::drawNoteOnBassClef(Graphics& g, int note, int prev_note, bool prev_note_offset, vector<int>* note_ys) {
-  bool did_offset = false;
-  int note_x = NOTE_X;
-  int distance = getLetterDistance(note, 48);
-
-  // Checking to add an x-offset to the note.
-  if(prev_note > 0) {
-    if(getLetterDistance(note, prev_note) < 2 && !prev_note_offset) {
-      note_x = note_x + X_LINE_DELTA;
-      did_offset = true;
-    }
-  }
-  
-  int note_y = MIDI_48_Y - (distance * NOTE_DELTA_Y);
-  g.drawImageAt(whole_note_image, note_x, note_y);
-  
-  note_ys->push_back(note_y);
-  
-  int num_ledger_lines = getNumberLedgerLines(distance);
-  drawLedgerLinesOnBassClef(g, num_ledger_lines, distance > 0);
-  return did_offset;
-}
-
-bool GrandStaffComponent::hasAccidental(int note) {
-    // Midi pitch 69 is A, so wrapped note 9 is A.
-  int wrapped_note = note % 12;
-  switch(wrapped_note) {
-    case 0:  // C
-    case 2:  // D
-    case 4:  // E
-    case 5:  // F
-    case 7:  // G
-    case 9:  // A
-    case 11: // B
-      return false;
-    case 1:  // C# / Db
-    case 3:  // D# / Eb
-    case 6:  // F# / Gb
-    case 8:  // G# / Ab
-    case 10: // A# / Bb
-      return true;
-   }
-  
-  // Other
-  return false;
-}
-
-void GrandStaffComponent::drawAccidental(Graphics& g, int x_ref, int y_ref) {
-  if(accidental_mode == ALL_SHARPS) {
-    drawSharp(g, x_ref, y_ref);
-  }
-  else if(accidental_mode == ALL_FLATS) {
-    drawFlat(g, x_ref, y_ref);
-  }
-}
-
-void GrandStaffComponent::drawSharp(Graphics& g, int x_ref, int y_ref) {
-  int x = x_ref + SHARP_X_OFFSET;
-  int y = y_ref + SHARP_Y_OFFSET;
-  g.drawImageAt(sharp_image, x, y);
-}
-
-void GrandStaffComponent::drawFlat(Graphics& g, int x_ref, int y_ref) {
-  int x = x_ref + FLAT_X_OFFSET;
-  int y = y_ref + FLAT_Y_OFFSET;
-  g.drawImageAt(flat_image, x, y);
-}
-
-// The cases for bass clef and treble clef are only the same because of the chosen reference notes.
-int GrandStaffComponent::getNumberLedgerLines(int distance) {
-  int num_lines = 0;
-  if(distance > 0) {
-    num_lines = (distance - 5) / 2;
-  }
-  else {
-    num_lines = ((distance * -1) -  3) / 2;
-  }
-  return max(num_lines, 0);
-}
-
-void GrandStaffComponent::drawLedgerLinesOnTrebleClef(Graphics& g, int num_ledger_lines, bool above_clef) {
-  int start_x = NOTE_X - 1;
-  int end_x = start_x + 15;
-  int y = 0;
-  int y_delta = 0;
-  if(above_clef) {
-    y = MIDI_69_Y + (NOTE_DELTA_Y * -7) + 7;
-    y_delta = NOTE_DELTA_Y * -2;
-  }
-  else {
-    y = MIDI_69_Y + (NOTE_DELTA_Y * 5) + 6;
-    y_delta = NOTE_DELTA_Y * 2;
-  }
-  
-  for(int i = 0; i < num_ledger_lines; i++) {
-    g.drawLine(start_x, y, end_x, y);
-    y = y + y_delta;
-  }
-}
-
-void GrandStaffComponent::drawLedgerLinesOnBassClef(Graphics& g, int num_ledger_lines, bool above_clef) {
-  int start_x = NOTE_X - 1;
-  int end_x = start_x + 15;
-  int y = 0;
-  int y_delta = 0;
-  if(above_clef) {
-    y = MIDI_48_Y + (NOTE_DELTA_Y * -7) + 7;
-    y_delta = NOTE_DELTA_Y * -2;
-  }
-  else {
-    y = MIDI_48_Y + (NOTE_DELTA_Y * 5) + 6;
-    y_delta = NOTE_DELTA_Y * 2;
-  }
-  
-  for(int i = 0; i < num_ledger_lines; i++) {
-    g.drawLine(start_x, y, end_x, y);
-    y = y + y_delta;
-  }
-}
-
-bool GrandStaffComponent::isInLine(int note, int ref) {
-  int distance = getLetterDistance(note, ref);
-  return abs(distance) % 2 == 0;
-}
-
-// Positive when the note is above the reference.
-int GrandStaffComponent::getLetterDistance(int note, int ref_pitch) {
-  if(note == ref_pitch) {
-    return 0;
-  }
-  
-  int note_letter = getNoteLetter(note);
-  int ref_letter = getNoteLetter(ref_pitch);
-  
-  // This allows Ab/A to count as an octave in the treble clef, and C#/C to be an octave in bass cleff.
-  int dst = abs(note - ref_pitch);
-  if(ref_letter == note_letter) {
-    dst = dst + 1;
-  }
-  
-  int distance_octaves = dst / 12;
-
-  int distance_within_octave = 0;
-  if(note > ref_pitch) {
-    distance_within_octave = lettersAboveReference(note_letter, ref_letter);
-  }
-  else {
-    distance_within_octave = lettersBelowReference(note_letter, ref_letter);
-  }
-  
-  int distance = (distance_octaves * OCTAVE_DELTA) + distance_within_octave;
-  return note > ref_pitch ? distance : -1 * distance;
-}
-
-Letter GrandStaffComponent::getNoteLetter(int note) {
-  // Midi pitch 69 is A, so wrapped note 9 is A.
-  int wrapped_note = note % 12;
-  switch(wrapped_note) {
-    // C
-    case 0: {
-      return C;
-    }
-    // C# / Db
-    case 1: {
-      if(accidental_mode == ALL_SHARPS) {
-        return C;
-      }
-      if(accidental_mode == ALL_FLATS) {
-        return D;
-      }
-      break;
-    }
-    // D
-    case 2: {
-      return D;
-    }
-    // D# / Eb
-    case 3: {
-      if(accidental_mode == ALL_SHARPS) {
-        return D;
-      }
-      if(accidental_mode == ALL_FLATS) {
-        return E;
-      }
-      break;
-    }
-    // E
-    case 4: {
-      return E;
-    }
-    // F
-    case 5: {
-      return F;
-    }
-    // F# / Gb
-    case 6: {
-      if(accidental_mode == ALL_SHARPS) {
-        return F;
-      }
-      if(accidental_mode == ALL_FLATS) {
-        return G;
-      }
-      break;
-    }
-    // G
-    case 7: {
-      return G;
-    }
-    // G# / Ab
-    case 8: {
-      if(accidental_mode == ALL_SHARPS) {
-        return G;
-      }
-      if(accidental_mode == ALL_FLATS) {
-        return A;
-      }
-      break;
-    }
-    // A
-    case 9: {
-      return A;
-    }
-    // A# / Bb
-    case 10: {
-      if(accidental_mode == ALL_SHARPS) {
-        return A;
-      }
-      if(accidental_mode == ALL_FLATS) {
-        return B;
-      }
-      break;
-    }
-    // B
-    case 11: {
-      return B;
-    }
-  }
-  return MISTAKE;
-}
-
-// Always positive. E.g. note_letter = C, ref_letter = G, returns 3.
-int GrandStaffComponent::lettersAboveReference(int note_letter, int ref_letter) {
-  if(note_letter < ref_letter) {
-    note_letter = note_letter + OCTAVE_DELTA;
-  }
-  return note_letter - ref_letter;
-}
-
-// Always positive. E.g. note_letter = C, ref_letter = G, returns 4.
-int GrandStaffComponent::lettersBelowReference(int note_letter, int ref_letter) {
-  if(note_letter > ref_letter) {
-    note_letter = note_letter - OCTAVE_DELTA;
-  }
-  return ref_letter - note_letter;
-}
+/*
+ * GrandStaffComponent.cpp file header.
+ *
+ * Chris Laguna
+ */
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "GrandStaffComponent.h"
+#include "NoteRange.h"
+#include "PaintProfiler.h"
+
+namespace {
+  // Profiler scope names for each clef's draw functions, in ClefType order.
+  const char* const DRAW_NOTE_SCOPES[NUM_CLEF_TYPES] = {
+    "drawNoteOnTrebleClef", "drawNoteOnBassClef", "drawNoteOnAltoClef", "drawNoteOnTenorClef",
+    "drawNoteOnTreble8vaClef", "drawNoteOnBass8vbClef"
+  };
+  const char* const DRAW_LEDGER_LINES_SCOPES[NUM_CLEF_TYPES] = {
+    "drawLedgerLinesOnTrebleClef", "drawLedgerLinesOnBassClef", "drawLedgerLinesOnAltoClef",
+    "drawLedgerLinesOnTenorClef", "drawLedgerLinesOnTreble8vaClef", "drawLedgerLinesOnBass8vbClef"
+  };
+}
+
+/***** Public members *****/
+
+StaffGlyphs::StaffGlyphs() {
+  // Convert images from binary data to Images.
+  grand_staff_image = loadScaled(BinaryData::Grand_Staff_png, BinaryData::Grand_Staff_pngSize, GRAND_STAFF_HEIGHT);
+  whole_note_image = loadScaled(BinaryData::Whole_Note_png, BinaryData::Whole_Note_pngSize, WHOLE_NOTE_HEIGHT);
+  flat_image = loadScaled(BinaryData::Flat_png, BinaryData::Flat_pngSize, FLAT_HEIGHT);
+  sharp_image = loadScaled(BinaryData::Sharp_png, BinaryData::Sharp_pngSize, SHARP_HEIGHT);
+  
+  int middle_y = grand_staff_image.getHeight() / 2;
+  upper_clef_bounds = findClefBounds(grand_staff_image, 0, middle_y);
+  lower_clef_bounds = findClefBounds(grand_staff_image, middle_y, grand_staff_image.getHeight());
+  jassert(!upper_clef_bounds.isEmpty() && !lower_clef_bounds.isEmpty());
+}
+
+Image StaffGlyphs::loadScaled(const void* data, int data_size, float height) {
+  Image image = ImageFileFormat::loadFrom(data, data_size);
+  int actual_height = image.getHeight();
+  int actual_width = image.getWidth();
+  float scale_factor = height / (float) actual_height;
+  return image.rescaled(actual_width * scale_factor, actual_height * scale_factor);
+}
+
+Rectangle<int> StaffGlyphs::findClefBounds(const Image& image, int top, int bottom) {
+  Image::BitmapData pixels(image, Image::BitmapData::readOnly);
+  int width = image.getWidth();
+  
+  // Staff lines are the rows inked across most of the image. The rest of the ink belongs to the
+  // symbols, which are told apart by the columns it is in.
+  std::vector<bool> line_row(bottom - top, false);
+  int top_line = -1;
+  int bottom_line = -1;
+  for(int y = top; y < bottom; y++) {
+    int num_inked = 0;
+    for(int x = 0; x < width; x++) {
+      num_inked += isInk(pixels, x, y);
+    }
+    if(num_inked > width / 2) {
+      line_row[y - top] = true;
+      top_line = top_line < 0 ? y : top_line;
+      bottom_line = y;
+    }
+  }
+  if(top_line < 0) {
+    return Rectangle<int>();
+  }
+  
+  std::vector<int> column_ink(width, 0);
+  std::vector<int> column_staff_ink(width, 0);  // Only the rows between the top and bottom lines.
+  int num_staff_rows = 0;
+  for(int y = top; y < bottom; y++) {
+    if(line_row[y - top]) {
+      continue;
+    }
+    bool in_staff = y > top_line && y < bottom_line;
+    num_staff_rows += in_staff;
+    for(int x = 0; x < width; x++) {
+      if(isInk(pixels, x, y)) {
+        column_ink[x]++;
+        column_staff_ink[x] += in_staff;
+      }
+    }
+  }
+  
+  // From the left, the inked columns are the brace, the barline, then the clef. The barline is
+  // the last of the first narrow runs of columns that cover the whole staff (a thin brace can
+  // look like one too). If the brace touches it they are one run, and the clef starts after it.
+  std::vector<Range<int>> runs;
+  int barline_run = -1;
+  for(int x = 0; x < width; x++) {
+    if(column_ink[x] == 0) {
+      continue;
+    }
+    int start = x;
+    bool covers_staff = false;
+    for(; x < width && column_ink[x] > 0; x++) {
+      covers_staff = covers_staff || column_staff_ink[x] == num_staff_rows;
+    }
+    bool in_first_group = barline_run < 0 || barline_run == (int) runs.size() - 1;
+    if(in_first_group && covers_staff && x - start <= MAX_BARLINE_WIDTH) {
+      barline_run = (int) runs.size();
+    }
+    runs.push_back(Range<int>(start, x));
+  }
+  size_t first_clef_run = barline_run >= 0 ? barline_run + 1 : 1;
+  if(first_clef_run >= runs.size()) {
+    return Rectangle<int>();
+  }
+  
+  Range<int> clef_columns = runs[first_clef_run];
+  for(size_t run = first_clef_run + 1; run < runs.size(); run++) {
+    if(runs[run].getStart() - clef_columns.getEnd() > MAX_CLEF_GAP) {
+      break;
+    }
+    clef_columns = clef_columns.getUnionWith(runs[run]);
+  }
+  
+  int clef_top = bottom;
+  int clef_bottom = top;
+  for(int y = top; y < bottom; y++) {
+    for(int x = clef_columns.getStart(); x < clef_columns.getEnd() && !line_row[y - top]; x++) {
+      if(isInk(pixels, x, y)) {
+        clef_top = jmin(clef_top, y);
+        clef_bottom = y + 1;
+        break;
+      }
+    }
+  }
+  return Rectangle<int>(clef_columns.getStart(), clef_top, clef_columns.getLength(), clef_bottom - clef_top);
+}
+
+bool StaffGlyphs::isInk(const Image::BitmapData& pixels, int x, int y) {
+  Colour colour = pixels.getPixelColour(x, y);
+  return colour.getAlpha() > 127 && colour.getPerceivedBrightness() < 0.5f;
+}
+
+GrandStaffComponent::GrandStaffComponent() : displayed_snapshot() {
+  for(int note = 0; note < 128; note++) {
+    note_on_staff[note] = false;
+    hold_count[note] = 0;
+    note_on_upper_staff[note] = false;
+    note_states[note] = NOTE_HELD;
+    note_velocities[note] = 127;
+  }
+  notes_to_draw.reserve(128);
+  
+  upper_staff.reference_y = UPPER_REFERENCE_Y;
+  lower_staff.reference_y = LOWER_REFERENCE_Y;
+  setStaffClef(&upper_staff, TREBLE_CLEF);
+  setStaffClef(&lower_staff, BASS_CLEF);
+}
+
+GrandStaffComponent::~GrandStaffComponent() {
+  notes_to_draw.clear();
+}
+
+void GrandStaffComponent::paint (Graphics& g) {
+  PAINT_PROFILE_SCOPE("GrandStaffComponent::paint");
+  
+  // Draw the staff.
+  {
+    PAINT_PROFILE_SCOPE("staff blit");
+    g.fillAll (Colours::white);
+    g.drawImageAt(glyphs->grand_staff_image, 0, STAFF_Y_OFFSET);
+    g.setColour(HELD_NOTE_COLOUR);
+    (this->*upper_staff.draw_clef)(g, upper_staff.reference_y, true);
+    (this->*lower_staff.draw_clef)(g, lower_staff.reference_y, false);
+  }
+  
+  double now_ms = Time::getMillisecondCounterHiRes();
+  
+  vector<int> note_ys;
+  // Draw each note individually. Notes keep the staff they were added on, so the staves can
+  // interleave in |notes_to_draw|; each one keeps track of its own previous note (upper is 1).
+  int prev_note[2] = { 0, 0 };
+  bool prev_note_offset[2] = { false, false };
+  for(int note_idx = 0; note_idx < notes_to_draw.size(); note_idx++) {
+    int cur_note = notes_to_draw[note_idx];
+    int staff = drawOnTrebleClef(cur_note) ? 1 : 0;
+    
+    g.setColour(getNoteColour(cur_note, now_ms));
+    prev_note_offset[staff] = drawNote(g, cur_note, prev_note[staff], prev_note_offset[staff], &note_ys);
+    prev_note[staff] = cur_note;
+  }
+
+  PAINT_PROFILE_SCOPE("accidentals");
+  int prev_accidental[2] = { 0, 0 };
+  int cur_x[2] = { NOTE_X, NOTE_X };
+  for(int note_idx = notes_to_draw.size() - 1; note_idx >= 0; note_idx--) {
+    int cur_note = notes_to_draw[note_idx];
+    int staff = drawOnTrebleClef(cur_note) ? 1 : 0;
+    
+    if(hasAccidental(cur_note)) {
+      if(prev_accidental[staff] == 0 || abs(getLetterDistance(cur_note, prev_accidental[staff])) > 4) {
+        prev_accidental[staff] = cur_note;
+        cur_x[staff] = NOTE_X;
+      }
+      else {
+        cur_x[staff] += ACCIDENTAL_X_DELTA;
+      }
+
+      g.setColour(getNoteColour(cur_note, now_ms));
+      Rectangle<int> accidental_bounds = drawAccidental(g, cur_x[staff], note_ys[note_idx]);
+      note_animations[cur_note].bounds = note_animations[cur_note].bounds.getUnion(accidental_bounds);
+    }
+  }
+  
+  g.setColour(HELD_NOTE_COLOUR);
+}
+
+void GrandStaffComponent::resized() {}
+
+void GrandStaffComponent::addNote(int midi_pitch) {
+  // Only add notes within the range of the keyboard.
+  if(midi_pitch < NoteRange::MIN_NOTE || midi_pitch > NoteRange::MAX_NOTE) {
+    return;
+  }
+  
+  if(hold_count[midi_pitch]++ > 0) {
+    return;
+  }
+  // Every key press goes through the estimator, even one that only brings back a fading note.
+  bool upper = assignStaff(midi_pitch);
+  
+  // Pressing a key again while its note is fading out just brings the note back.
+  NoteAnimation& animation = note_animations[midi_pitch];
+  if(animation.releasing) {
+    animation.releasing = false;
+    num_animating--;
+    repaint(animation.bounds);
+    return;
+  }
+  
+  if(note_on_staff[midi_pitch]) {
+    return;
+  }
+  note_on_staff[midi_pitch] = true;
+  note_on_upper_staff[midi_pitch] = upper;
+  rebuildNotesToDraw();
+  repaint();
+}
+
+void GrandStaffComponent::removeNote(int midi_pitch) {
+  // Only remove notes within the range of the keyboard.
+  if(midi_pitch < NoteRange::MIN_NOTE || midi_pitch > NoteRange::MAX_NOTE) {
+    return;
+  }
+  
+  // Unmatched, or still held on another channel.
+  if(hold_count[midi_pitch] == 0 || --hold_count[midi_pitch] > 0) {
+    return;
+  }
+  hand_split.noteOff(midi_pitch);
+  
+  NoteAnimation& animation = note_animations[midi_pitch];
+  if(animation.releasing) {
+    return;
+  }
+  if(!note_on_staff[midi_pitch]) {
+    return;
+  }
+  if(release_time_ms <= 0) {
+    eraseNote(midi_pitch);
+    return;
+  }
+  
+  // Leave the note where it is and let the timer fade it out.
+  animation.releasing = true;
+  animation.release_start_ms = Time::getMillisecondCounterHiRes();
+  num_animating++;
+  if(!isTimerRunning()) {
+    startTimerHz(ANIMATION_FRAME_RATE);
+  }
+}
+
+void GrandStaffComponent::setNoteStyle(int midi_pitch, NoteState state, int velocity) {
+  if(note_states[midi_pitch] == state && note_velocities[midi_pitch] == velocity) {
+    return;
+  }
+  note_states[midi_pitch] = (uint8) state;
+  note_velocities[midi_pitch] = (uint8) velocity;
+  if(note_on_staff[midi_pitch]) {
+    repaint(note_animations[midi_pitch].bounds.expanded(2));
+  }
+}
+
+void GrandStaffComponent::setSnapshot(const NoteSnapshot& snapshot) {
+  for(int note = NoteRange::MIN_NOTE; note <= NoteRange::MAX_NOTE; note++) {
+    if(snapshot.isSounding(note)) {
+      setNoteStyle(note, (NoteState) snapshot.state[note], snapshot.velocity[note]);
+      if(!displayed_snapshot.isSounding(note)) {
+        addNote(note);
+      }
+    }
+    else if(displayed_snapshot.isSounding(note)) {
+      removeNote(note);
+    }
+    else if(snapshot.wasStruckSince(displayed_snapshot, note)) {
+      // Struck and released since the last snapshot: show it, and let it fade straight away.
+      setNoteStyle(note, NOTE_HELD, snapshot.velocity[note]);
+      addNote(note);
+      removeNote(note);
+    }
+  }
+  displayed_snapshot = snapshot;
+}
+
+void GrandStaffComponent::setAccidentalMode(AccidentalMode at) {
+  accidental_mode = at;
+}
+
+void GrandStaffComponent::setClefs(ClefType upper_clef, ClefType lower_clef) {
+  if(upper_clef == upper_staff.clef && lower_clef == lower_staff.clef) {
+    return;
+  }
+  setStaffClef(&upper_staff, upper_clef);
+  setStaffClef(&lower_staff, lower_clef);
+  repaint();
+}
+
+void GrandStaffComponent::resetHandSplit() {
+  hand_split.reset();
+}
+
+void GrandStaffComponent::setReleaseTime(int milliseconds) {
+  release_time_ms = max(milliseconds, 0);
+}
+
+/***** Private Members *****/
+
+void GrandStaffComponent::setStaffClef(Staff* staff, ClefType clef) {
+  switch(clef) {
+    case TREBLE_CLEF:
+      bindClef<TrebleClef>(staff);
+      break;
+    case BASS_CLEF:
+      bindClef<BassClef>(staff);
+      break;
+    case ALTO_CLEF:
+      bindClef<AltoClef>(staff);
+      break;
+    case TENOR_CLEF:
+      bindClef<TenorClef>(staff);
+      break;
+    case TREBLE_8VA_CLEF:
+      bindClef<Treble8vaClef>(staff);
+      break;
+    case BASS_8VB_CLEF:
+      bindClef<Bass8vbClef>(staff);
+      break;
+    default:
+      jassertfalse;
+      break;
+  }
+}
+
+template <class Clef>
+void GrandStaffComponent::bindClef(Staff* staff) {
+  staff->clef = Clef::TYPE;
+  staff->draw_note = &GrandStaffComponent::drawNoteOnClef<Clef>;
+  staff->draw_clef = &GrandStaffComponent::drawClef<Clef>;
+  staff->count_ledger_lines = &GrandStaffComponent::countLedgerLines<Clef>;
+}
+
+void GrandStaffComponent::timerCallback() {
+  double now_ms = Time::getMillisecondCounterHiRes();
+  bool layout_changed = false;
+  
+  for(int note = 0; note < 128 && num_animating > 0; note++) {
+    NoteAnimation& animation = note_animations[note];
+    if(!animation.releasing) {
+      continue;
+    }
+    
+    if(now_ms - animation.release_start_ms >= release_time_ms) {
+      // Done fading. The rest of the chord may move, so this needs a full repaint.
+      animation.releasing = false;
+      num_animating--;
+      note_on_staff[note] = false;
+      layout_changed = true;
+    }
+    else {
+      // Expanded a little to cover the antialiased edges of the ledger lines.
+      repaint(animation.bounds.expanded(2));
+    }
+  }
+  
+  if(layout_changed) {
+    rebuildNotesToDraw();
+    repaint();
+  }
+  
+  if(num_animating == 0) {
+    stopTimer();
+  }
+}
+
+void GrandStaffComponent::eraseNote(int midi_pitch) {
+  NoteAnimation& animation = note_animations[midi_pitch];
+  if(animation.releasing) {
+    animation.releasing = false;
+    num_animating--;
+  }
+  
+  note_on_staff[midi_pitch] = false;
+  rebuildNotesToDraw();
+  repaint();
+}
+
+Colour GrandStaffComponent::getNoteColour(int note, double now_ms) {
+  Colour colour = note_states[note] == NOTE_HELD ? HELD_NOTE_COLOUR : PEDAL_NOTE_COLOUR;
+  
+  // Softer notes are lighter.
+  float alpha = getVelocityAlpha(note_velocities[note]);
+  
+  const NoteAnimation& animation = note_animations[note];
+  if(animation.releasing && release_time_ms > 0) {
+    double progress = (now_ms - animation.release_start_ms) / release_time_ms;
+    alpha *= (float) jlimit(0.0, 1.0, 1.0 - progress);
+  }
+  return colour.withAlpha(alpha);
+}
+
+void GrandStaffComponent::rebuildNotesToDraw() {
+  // Walking the keyboard keeps the list sorted without searching or sorting it.
+  notes_to_draw.clear();
+  for(int note = NoteRange::MIN_NOTE; note <= NoteRange::MAX_NOTE; note++) {
+    if(note_on_staff[note]) {
+      notes_to_draw.push_back(note);
+    }
+  }
+}
+
+bool GrandStaffComponent::assignStaff(int midi_pitch) {
+  bool upper = hand_split.noteOn(midi_pitch) == HandSplitEstimator::RIGHT_HAND;
+  
+  // A hand reaching into the other's range would pile up ledger lines on its own staff.
+  const Staff& own_staff = upper ? upper_staff : lower_staff;
+  const Staff& other_staff = upper ? lower_staff : upper_staff;
+  int own_lines = (this->*own_staff.count_ledger_lines)(midi_pitch);
+  if(own_lines > MAX_CROSSING_LEDGER_LINES
+     && (this->*other_staff.count_ledger_lines)(midi_pitch) < own_lines) {
+    upper = !upper;
+  }
+  return upper;
+}
+
+bool GrandStaffComponent::drawOnTrebleClef(int note) {
+  return note_on_upper_staff[note];
+}
+
+bool GrandStaffComponent::drawNote(Graphics& g, int note, int prev_note, bool prev_note_offset, vector<int>* note_ys) {
+  PAINT_PROFILE_SCOPE("drawNote");
+  const Staff& staff = drawOnTrebleClef(note) ? upper_staff : lower_staff;
+  return (this->*staff.draw_note)(g, note, prev_note, prev_note_offset, staff.reference_y, note_ys);
+}
+
+template <class Clef>
+bool GrandStaffComponent::drawNoteOnClef(Graphics& g, int note, int prev_note, bool prev_note_offset, int reference_y, vector<int>* note_ys) {
+  PAINT_PROFILE_SCOPE(DRAW_NOTE_SCOPES[Clef::TYPE]);
+  bool did_offset = false;
+  int note_x = NOTE_X;
+  int distance = getLetterDistance(note, Clef::REFERENCE_PITCH);
+  
+  // Checking to add an x-offset to the note.
+  if(prev_note > 0) {
+    if(getLetterDistance(note, prev_note) < 2 && !prev_note_offset) {
+      note_x = note_x + X_LINE_DELTA;
+      did_offset = true;
+    }
+  }
+  
+  int note_y = reference_y - (distance * NOTE_DELTA_Y);
+  g.drawImageAt(glyphs->whole_note_image, note_x, note_y, true);
+  
+  note_ys->push_back(note_y);
+  
+  int num_ledger_lines = Clef::getNumberLedgerLines(distance);
+  Rectangle<int> ledger_bounds = drawLedgerLinesOnClef<Clef>(g, num_ledger_lines, distance > 0, reference_y);
+  note_animations[note].bounds = glyphs->whole_note_image.getBounds().withPosition(note_x, note_y).getUnion(ledger_bounds);
+  return did_offset;
+}
+
+template <class Clef>
+void GrandStaffComponent::drawClef(Graphics& g, int reference_y, bool upper) {
+  Rectangle<int> clef_bounds = (upper ? glyphs->upper_clef_bounds : glyphs->lower_clef_bounds)
+      .translated(0, STAFF_Y_OFFSET);
+  
+  // The staff image only has a treble clef on the upper staff and a bass clef on the lower one.
+  // Until there are glyph images for the others, a clef it doesn't have blanks out the symbol
+  // that is there, puts the staff lines back and letters the line the clef marks.
+  ClefGlyph image_glyph = upper ? G_CLEF : F_CLEF;
+  if(Clef::GLYPH != image_glyph) {
+    static const char* const glyph_letters[] = { "G", "F", "C" };
+    g.setColour(Colours::white);
+    g.fillRect(clef_bounds);
+    g.setColour(HELD_NOTE_COLOUR);
+    for(int line = Clef::BOTTOM_LINE; line <= Clef::TOP_LINE; line += 2) {
+      int y = getLineY(reference_y, line);
+      g.drawLine(clef_bounds.getX(), y, clef_bounds.getRight(), y);
+    }
+    int glyph_y = getLineY(reference_y, Clef::GLYPH_LINE);
+    g.setFont(Font(CLEF_LETTER_HEIGHT, Font::bold));
+    g.drawText(glyph_letters[Clef::GLYPH], clef_bounds.getX(), glyph_y - CLEF_LETTER_HEIGHT / 2,
+               clef_bounds.getWidth(), CLEF_LETTER_HEIGHT, Justification::centred, false);
+  }
+  
+  // Octave clefs have a small 8 over or under the symbol.
+  if(Clef::OCTAVE_SHIFT != 0) {
+    int top_y = jmin(clef_bounds.getY(), getLineY(reference_y, Clef::TOP_LINE));
+    int bottom_y = jmax(clef_bounds.getBottom(), getLineY(reference_y, Clef::BOTTOM_LINE));
+    int y = Clef::OCTAVE_SHIFT > 0 ? top_y - OCTAVE_MARK_HEIGHT : bottom_y;
+    g.setFont(Font(OCTAVE_MARK_HEIGHT, Font::italic));
+    g.drawText("8", clef_bounds.getX(), y, clef_bounds.getWidth(), OCTAVE_MARK_HEIGHT,
+               Justification::centred, false);
+  }
+}
+
+bool GrandStaffComponent::hasAccidental(int note) {
+    // Midi pitch 69 is A, so wrapped note 9 is A.
+  int wrapped_note = note % 12;
+  switch(wrapped_note) {
+    case 0:  // C
+    case 2:  // D
+    case 4:  // E
+    case 5:  // F
+    case 7:  // G
+    case 9:  // A
+    case 11: // B
+      return false;
+    case 1:  // C# / Db
+    case 3:  // D# / Eb
+    case 6:  // F# / Gb
+    case 8:  // G# / Ab
+    case 10: // A# / Bb
+      return true;
+   }
+  
+  // Other
+  return false;
+}
+
+Rectangle<int> GrandStaffComponent::drawAccidental(Graphics& g, int x_ref, int y_ref) {
+  if(accidental_mode == ALL_SHARPS) {
+    return drawSharp(g, x_ref, y_ref);
+  }
+  else if(accidental_mode == ALL_FLATS) {
+    return drawFlat(g, x_ref, y_ref);
+  }
+  return Rectangle<int>();
+}
+
+Rectangle<int> GrandStaffComponent::drawSharp(Graphics& g, int x_ref, int y_ref) {
+  int x = x_ref + SHARP_X_OFFSET;
+  int y = y_ref + SHARP_Y_OFFSET;
+  g.drawImageAt(glyphs->sharp_image, x, y, true);
+  return glyphs->sharp_image.getBounds().withPosition(x, y);
+}
+
+Rectangle<int> GrandStaffComponent::drawFlat(Graphics& g, int x_ref, int y_ref) {
+  int x = x_ref + FLAT_X_OFFSET;
+  int y = y_ref + FLAT_Y_OFFSET;
+  g.drawImageAt(glyphs->flat_image, x, y, true);
+  return glyphs->flat_image.getBounds().withPosition(x, y);
+}
+
+template <class Clef>
+int GrandStaffComponent::countLedgerLines(int note) {
+  return Clef::getNumberLedgerLines(getLetterDistance(note, Clef::REFERENCE_PITCH));
+}
+
+template <class Clef>
+Rectangle<int> GrandStaffComponent::drawLedgerLinesOnClef(Graphics& g, int num_ledger_lines, bool above_clef, int reference_y) {
+  PAINT_PROFILE_SCOPE(DRAW_LEDGER_LINES_SCOPES[Clef::TYPE]);
+  int start_x = NOTE_X - 1;
+  int end_x = start_x + 15;
+  int y = 0;
+  int y_delta = 0;
+  if(above_clef) {
+    y = getLineY(reference_y, Clef::FIRST_LEDGER_ABOVE);
+    y_delta = NOTE_DELTA_Y * -2;
+  }
+  else {
+    y = getLineY(reference_y, Clef::FIRST_LEDGER_BELOW);
+    y_delta = NOTE_DELTA_Y * 2;
+  }
+  
+  Rectangle<int> bounds;
+  for(int i = 0; i < num_ledger_lines; i++) {
+    g.drawLine(start_x, y, end_x, y);
+    bounds = bounds.getUnion(Rectangle<int>(start_x, y, end_x - start_x, 1));
+    y = y + y_delta;
+  }
+  return bounds;
+}
+
+int GrandStaffComponent::getLineY(int reference_y, int distance) {
+  return (int) (reference_y - distance * NOTE_DELTA_Y + (distance > 0 ? LINE_Y_OFFSET_ABOVE : LINE_Y_OFFSET_BELOW));
+}
+
+bool GrandStaffComponent::isInLine(int note, int ref) {
+  int distance = getLetterDistance(note, ref);
+  return abs(distance) % 2 == 0;
+}
+
+// Positive when the note is above the reference.
+int GrandStaffComponent::getLetterDistance(int note, int ref_pitch) {
+  if(note == ref_pitch) {
+    return 0;
+  }
+  
+  int note_letter = getNoteLetter(note);
+  int ref_letter = getNoteLetter(ref_pitch);
+  
+  // This allows Ab/A to count as an octave in the treble clef, and C#/C to be an octave in bass cleff.
+  int dst = abs(note - ref_pitch);
+  if(ref_letter == note_letter) {
+    dst = dst + 1;
+  }
+  
+  int distance_octaves = dst / 12;
+
+  int distance_within_octave = 0;
+  if(note > ref_pitch) {
+    distance_within_octave = lettersAboveReference(note_letter, ref_letter);
+  }
+  else {
+    distance_within_octave = lettersBelowReference(note_letter, ref_letter);
+  }
+  
+  int distance = (distance_octaves * OCTAVE_DELTA) + distance_within_octave;
+  return note > ref_pitch ? distance : -1 * distance;
+}
+
+Letter GrandStaffComponent::getNoteLetter(int note) {
+  // Midi pitch 69 is A, so wrapped note 9 is A.
+  int wrapped_note = note % 12;
+  switch(wrapped_note) {
+    // C
+    case 0: {
+      return C;
+    }
+    // C# / Db
+    case 1: {
+      if(accidental_mode == ALL_SHARPS) {
+        return C;
+      }
+      if(accidental_mode == ALL_FLATS) {
+        return D;
+      }
+      break;
+    }
+    // D
+    case 2: {
+      return D;
+    }
+    // D# / Eb
+    case 3: {
+      if(accidental_mode == ALL_SHARPS) {
+        return D;
+      }
+      if(accidental_mode == ALL_FLATS) {
+        return E;
+      }
+      break;
+    }
+    // E
+    case 4: {
+      return E;
+    }
+    // F
+    case 5: {
+      return F;
+    }
+    // F# / Gb
+    case 6: {
+      if(accidental_mode == ALL_SHARPS) {
+        return F;
+      }
+      if(accidental_mode == ALL_FLATS) {
+        return G;
+      }
+      break;
+    }
+    // G
+    case 7: {
+      return G;
+    }
+    // G# / Ab
+    case 8: {
+      if(accidental_mode == ALL_SHARPS) {
+        return G;
+      }
+      if(accidental_mode == ALL_FLATS) {
+        return A;
+      }
+      break;
+    }
+    // A
+    case 9: {
+      return A;
+    }
+    // A# / Bb
+    case 10: {
+      if(accidental_mode == ALL_SHARPS) {
+        return A;
+      }
+      if(accidental_mode == ALL_FLATS) {
+        return B;
+      }
+      break;
+    }
+    // B
+    case 11: {
+      return B;
+    }
+  }
+  return MISTAKE;
+}
+
+// Always positive. E.g. note_letter = C, ref_letter = G, returns 3.
+int GrandStaffComponent::lettersAboveReference(int note_letter, int ref_letter) {
+  if(note_letter < ref_letter) {
+    note_letter = note_letter + OCTAVE_DELTA;
+  }
+  return note_letter - ref_letter;
+}
+
+// Always positive. E.g. note_letter = C, ref_letter = G, returns 4.
+int GrandStaffComponent::lettersBelowReference(int note_letter, int ref_letter) {
+  if(note_letter > ref_letter) {
+    note_letter = note_letter - OCTAVE_DELTA;
+  }
+  return ref_letter - note_letter;
+}
@@ -1,133 +1,253 @@
-/*
- * Component for drawing the staff notation.
- * Chris Laguna
- */
-
-#ifndef GRANDSTAFFCOMPONENT_H_INCLUDED
-#define GRANDSTAFFCOMPONENT_H_INCLUDED
-
-#include "../JuceLibraryCode/JuceHeader.h"
-
-using namespace std;
-
-/*
- * To answer the question "Is this a C# or a Db?". This depends on the musical context, which we can't
- * know (or is difficult to know) programatically. However, we can assume that someone is playing
- * in a key, and then use the accidentals used in that key. For now, we handle only the simple cases
- * where a key uses only sharps or only flats, and all white keys are natural.
- * TODO: Extend this to work for the harder keys, e.g. C# major.
- */
-enum AccidentalMode {
-  ALL_SHARPS,
-  ALL_FLATS
-};
-
-/*
- * Note letters. The line or space a note is drawn on depends on the note letter, not
- * on the note's MIDI pitch.
- */
-enum Letter {
-  A = 0,
-  B,
-  C,
-  D,
-  E,
-  F,
-  G,
-  MISTAKE  // Sanity.
-};
-
-class GrandStaffComponent : public Component {
-public:
-  GrandStaffComponent();
-  virtual ~GrandStaffComponent();
-
-  void paint (Graphics&) override;
-  void resized() override;
-  
-  void addNote(int midi_pitch);
-  void removeNote(int midi_pitch);
-
-  void setAccidentalMode(AccidentalMode at);
-  
-private:
-  // Drawing is just placing a bunch of images on top of each other.
-  Image grand_staff_image;
-  Image whole_note_image;
-  Image flat_image;
-  Image sharp_image;
-  
-  /*
-   * The notes that should be drawn at any given time. Midi note-on and note-off messages are
-   * handled by simply adding and removing notes from this list. Drawing happens in repaint,
-   * of course.
-   */
-  std::vector<int> notes_to_draw;
-  
-  AccidentalMode accidental_mode = ALL_SHARPS;
-  
-  // A bunch of hard-coded values to draw the images in the correct spots.
-  const float GRAND_STAFF_HEIGHT = 100.f;
-  const float WHOLE_NOTE_HEIGHT = 13.f;
-  const float SHARP_HEIGHT = 37.f;
-  const float FLAT_HEIGHT = 28.f;
-  
-  const int STAFF_Y_OFFSET = 65;  // Staff y position on the component.
-  
-  const float NOTE_DELTA_Y = 3.5;            // Number of pixels to the note up or
-                                             // down when changing pitch by a semitone.
-  const int NOTE_X = 66;                     // X position of every note on the staff.
-  const int X_LINE_DELTA = 8;                // Adjacent note heads need to be displaced on the x axis.
-  const int ACCIDENTAL_X_DELTA = -9;          // Adjacent accidentals need to be displaced on the x axis.
-  const int MIDI_69_Y = 20 + STAFF_Y_OFFSET; // Y position of A440 (midi pitch 69) on treble clef.
-  const int MIDI_48_Y = 83 + STAFF_Y_OFFSET; // Y position of C3 on (midi pitch 48) bass clef.
-  const int OCTAVE_DELTA = 7;                // Two notes an octave apart are separated by 7
-                                             // lines/spaces on the staff.
-  
-  const int SHARP_X_OFFSET = -22;  // Used to calculate the position of the sharp image relative to the whole note.
-  const int SHARP_Y_OFFSET = -12;  // Used to calculate the position of the sharp image relative to the whole note.
-  const int FLAT_X_OFFSET = -18;   // Used to calculate the position of the flat image relative to the whole note.
-  const int FLAT_Y_OFFSET = -13;   // Used to calculate the position of the flat image relative to the whole note.
-  
-  int bottom_treble_note;  // The lowest note currently being drawn in the treble clef.
-  int bottom_bass_note;    // The lowest note currently being drawn in the bass clef.
-  
-  void updateBottomNotes();  // Go through |notes_to_draw| and set the bottom treble and bass notes.
-  
-  // Repaint helpers.
-  bool drawOnTrebleClef(int note);  // Should the note be drawn on the treble clef? (or the bass clef)
-  bool drawNote(Graphics& g, int note, int prev_note, bool prev_note_offset, vector<int>* note_ys);
-  bool drawNoteOnTrebleClef(Graphics& g, int note, int prev_note, bool prev_note_offset, vector<int>* note_ys);
-  bool drawNoteOnBassClef(Graphics& g, int note, int prev_note, bool prev_note_offset, vector<int>* note_ys);
-  
-  bool hasAccidental(int note);
-  void drawAccidental(Graphics& g, int x_ref, int y_ref);
-  void drawSharp(Graphics& g, int x_ref, int y_ref);
-  void drawFlat(Graphics& g, int x_ref, int y_ref);
-  
-  int getNumberLedgerLines(int distance);
-  void drawLedgerLinesOnTrebleClef(Graphics& g, int num_ledger_lines, bool above_clef);
-  void drawLedgerLinesOnBassClef(Graphics& g, int num_ledger_lines, bool above_clef);
-  bool isInLine(int distance, int ref);  // Is the note on a line if the ref is on a line
-                                         // or is the note on a space if hte ref is on a space?
-  
-  /*
-   * If you thought getNoteLetter was trivial (like I did), you forgot about enharmonics. We
-   * have to consider things like "is this note F or E#?" (aka the accidental type).
-   */
-  Letter getNoteLetter(int note);
- 
-  /*
-   * How many lines/spaces apart is the current note from a reference pitch. This tells
-   * us where to draw the note.
-   */
-  int getLetterDistance(int note, int ref_pitch);
-  int lettersAboveReference(int note_letter, int ref_letter);
-  int lettersBelowReference(int note_letter, int ref_letter);
-  
-  
-  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (GrandStaffComponent)
-};
-
-
-#endif  // GRANDSTAFFCOMPONENT_H_INCLUDED
+/*
+ * Component for drawing the staff notation.
+ * Chris Laguna
+ */
+
+#ifndef GRANDSTAFFCOMPONENT_H_INCLUDED
+#define GRANDSTAFFCOMPONENT_H_INCLUDED
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "ClefGeometry.h"
+#include "HandSplitEstimator.h"
+#include "NoteStateModel.h"
+
+using namespace std;
+
+/*
+ * To answer the question "Is this a C# or a Db?". This depends on the musical context, which we can't
+ * know (or is difficult to know) programatically. However, we can assume that someone is playing
+ * in a key, and then use the accidentals used in that key. For now, we handle only the simple cases
+ * where a key uses only sharps or only flats, and all white keys are natural.
+ * TODO: Extend this to work for the harder keys, e.g. C# major.
+ */
+enum AccidentalMode {
+  ALL_SHARPS,
+  ALL_FLATS
+};
+
+/*
+ * Note letters. The line or space a note is drawn on depends on the note letter, not
+ * on the note's MIDI pitch.
+ */
+enum Letter {
+  A = 0,
+  B,
+  C,
+  D,
+  E,
+  F,
+  G,
+  MISTAKE  // Sanity.
+};
+
+/*
+ * The images used to draw the staff notation. Decoding and rescaling them is slow, so it is done
+ * once and the result is shared by every GrandStaffComponent (see SharedResourcePointer). After
+ * construction the images are only ever read, which lets the batch renderer's worker threads
+ * draw from the same copy.
+ */
+class StaffGlyphs {
+public:
+  StaffGlyphs();
+
+  Image grand_staff_image;
+  Image whole_note_image;
+  Image flat_image;
+  Image sharp_image;
+  
+  // Where the treble and bass clef symbols are in |grand_staff_image|, measured from its pixels
+  // after rescaling, so another clef can be drawn over one without touching the brace or barline.
+  Rectangle<int> upper_clef_bounds;
+  Rectangle<int> lower_clef_bounds;
+
+private:
+  // The heights the images are rescaled to.
+  const float GRAND_STAFF_HEIGHT = 100.f;
+  const float WHOLE_NOTE_HEIGHT = 13.f;
+  const float SHARP_HEIGHT = 37.f;
+  const float FLAT_HEIGHT = 28.f;
+  
+  static const int MAX_BARLINE_WIDTH = 3;  // Pixels, in the rescaled staff image.
+  static const int MAX_CLEF_GAP = 4;       // Blank columns between parts of a clef (the F clef's dots).
+
+  static Image loadScaled(const void* data, int data_size, float height);
+  static Rectangle<int> findClefBounds(const Image& image, int top, int bottom);
+  static bool isInk(const Image::BitmapData& pixels, int x, int y);
+
+  JUCE_DECLARE_NON_COPYABLE (StaffGlyphs)
+};
+
+class GrandStaffComponent : public Component,
+                            private Timer {
+public:
+  GrandStaffComponent();
+  virtual ~GrandStaffComponent();
+
+  void paint (Graphics&) override;
+  void resized() override;
+  
+  // Calls are counted, so a pitch added twice (e.g. held on two channels) stays until it has
+  // been removed twice.
+  void addNote(int midi_pitch);
+  void removeNote(int midi_pitch);
+  
+  // Notes held by a pedal and soft notes are drawn differently. Defaults to held at full velocity.
+  void setNoteStyle(int midi_pitch, NoteState state, int velocity);
+  
+  // Adds, removes and styles notes to match |snapshot|.
+  void setSnapshot(const NoteSnapshot& snapshot);
+
+  void setAccidentalMode(AccidentalMode at);
+  
+  // Defaults to treble over bass.
+  void setClefs(ClefType upper_clef, ClefType lower_clef);
+  
+  // Starts the hand split estimate over, e.g. when the input device changes. Notes still held
+  // keep counting until they are removed.
+  void resetHandSplit();
+  
+  // How long a released note takes to fade out. 0 removes released notes immediately.
+  void setReleaseTime(int milliseconds);
+  
+private:
+  // Drawing is just placing a bunch of images on top of each other.
+  SharedResourcePointer<StaffGlyphs> glyphs;
+  
+  /*
+   * The notes that should be drawn at any given time, lowest first. Midi note-on and note-off
+   * messages are handled by setting and clearing the note in |note_on_staff|, and rebuilding
+   * this list from it. Drawing happens in repaint, of course.
+   */
+  std::vector<int> notes_to_draw;
+  bool note_on_staff[128];
+  int hold_count[128];  // addNote calls not yet matched by removeNote.
+  void rebuildNotesToDraw();
+  
+  NoteSnapshot displayed_snapshot;  // The last snapshot passed to setSnapshot.
+  
+  // How each note is drawn (see setNoteStyle).
+  uint8 note_states[128];
+  uint8 note_velocities[128];
+  const Colour HELD_NOTE_COLOUR = Colours::black;
+  const Colour PEDAL_NOTE_COLOUR = Colour(30, 90, 200);
+  
+  AccidentalMode accidental_mode = ALL_SHARPS;
+  
+  /*
+   * A released note stays in |notes_to_draw| while it fades out, so the chord doesn't jump around
+   * under it. The fade state for every MIDI pitch lives in a fixed array, so starting, cancelling
+   * and finishing a fade never allocates. While notes are fading, the timer only repaints the
+   * area each of them covered the last time it was drawn, and it is stopped as soon as the last
+   * fade is done.
+   */
+  struct NoteAnimation {
+    bool releasing = false;
+    double release_start_ms = 0.0;
+    Rectangle<int> bounds;  // Note head, ledger lines and accidental, as last drawn.
+  };
+  NoteAnimation note_animations[128];
+  int num_animating = 0;
+  int release_time_ms = 0;
+  static const int ANIMATION_FRAME_RATE = 60;
+  
+  void timerCallback() override;
+  void eraseNote(int midi_pitch);     // Take the note out of |notes_to_draw| for good.
+  Colour getNoteColour(int note, double now_ms);
+  
+  // A bunch of hard-coded values to draw the images in the correct spots.
+  const int STAFF_Y_OFFSET = 65;  // Staff y position on the component.
+  
+  const float NOTE_DELTA_Y = 3.5;            // Number of pixels to the note up or
+                                             // down when changing pitch by a semitone.
+  const int NOTE_X = 66;                     // X position of every note on the staff.
+  const int X_LINE_DELTA = 8;                // Adjacent note heads need to be displaced on the x axis.
+  const int ACCIDENTAL_X_DELTA = -9;          // Adjacent accidentals need to be displaced on the x axis.
+  const int UPPER_REFERENCE_Y = 20 + STAFF_Y_OFFSET; // Y position of the second space of the upper staff (A4 in treble clef).
+  const int LOWER_REFERENCE_Y = 83 + STAFF_Y_OFFSET; // Y position of the second space of the lower staff (C3 in bass clef).
+  const int OCTAVE_DELTA = 7;                // Two notes an octave apart are separated by 7
+                                             // lines/spaces on the staff.
+  
+  const int SHARP_X_OFFSET = -22;  // Used to calculate the position of the sharp image relative to the whole note.
+  const int SHARP_Y_OFFSET = -12;  // Used to calculate the position of the sharp image relative to the whole note.
+  const int FLAT_X_OFFSET = -18;   // Used to calculate the position of the flat image relative to the whole note.
+  const int FLAT_Y_OFFSET = -13;   // Used to calculate the position of the flat image relative to the whole note.
+  
+  const int CLEF_LETTER_HEIGHT = 22;
+  const int OCTAVE_MARK_HEIGHT = 11;
+  const int LINE_Y_OFFSET_ABOVE = 7;  // From a note's y position to the y of the line through it,
+  const int LINE_Y_OFFSET_BELOW = 6;  // above the reference and at or below it (the image isn't even).
+  
+  /*
+   * Each staff draws with the functions instantiated for its clef (see ClefGeometry.h). They are
+   * picked in setClefs, so drawing a note doesn't check which clef it is on.
+   */
+  typedef bool (GrandStaffComponent::*DrawNoteFunction)(Graphics&, int, int, bool, int, vector<int>*);
+  typedef void (GrandStaffComponent::*DrawClefFunction)(Graphics&, int, bool);
+  typedef int (GrandStaffComponent::*CountLedgerLinesFunction)(int);
+  struct Staff {
+    ClefType clef;
+    int reference_y;
+    DrawNoteFunction draw_note;
+    DrawClefFunction draw_clef;
+    CountLedgerLinesFunction count_ledger_lines;
+  };
+  Staff upper_staff;
+  Staff lower_staff;
+  static void setStaffClef(Staff* staff, ClefType clef);
+  template <class Clef>
+  static void bindClef(Staff* staff);
+  
+  /*
+   * Each note's staff is picked when it is added, from the hand it was most likely played with,
+   * and kept until it is erased, so notes don't jump between staves while they are held.
+   */
+  HandSplitEstimator hand_split;
+  bool note_on_upper_staff[128];
+  const int MAX_CROSSING_LEDGER_LINES = 2;  // More than this on a hand's own staff, and the note
+                                            // goes on the other staff if it needs fewer there.
+  bool assignStaff(int midi_pitch);         // True for the upper staff.
+  
+  // Repaint helpers.
+  bool drawOnTrebleClef(int note);  // Is the note on the upper staff? (or the lower staff)
+  bool drawNote(Graphics& g, int note, int prev_note, bool prev_note_offset, vector<int>* note_ys);
+  template <class Clef>
+  bool drawNoteOnClef(Graphics& g, int note, int prev_note, bool prev_note_offset, int reference_y, vector<int>* note_ys);
+  
+  // Covers the symbol in the staff image when |Clef| uses a different one, and marks octave clefs.
+  template <class Clef>
+  void drawClef(Graphics& g, int reference_y, bool upper);
+  
+  bool hasAccidental(int note);
+  // The draw helpers return the area they drew on, for repainting fading notes.
+  Rectangle<int> drawAccidental(Graphics& g, int x_ref, int y_ref);
+  Rectangle<int> drawSharp(Graphics& g, int x_ref, int y_ref);
+  Rectangle<int> drawFlat(Graphics& g, int x_ref, int y_ref);
+  
+  template <class Clef>
+  int countLedgerLines(int note);
+  template <class Clef>
+  Rectangle<int> drawLedgerLinesOnClef(Graphics& g, int num_ledger_lines, bool above_clef, int reference_y);
+  int getLineY(int reference_y, int distance);  // Y of the line |distance| letters from the reference.
+  bool isInLine(int distance, int ref);  // Is the note on a line if the ref is on a line
+                                         // or is the note on a space if hte ref is on a space?
+  
+  /*
+   * If you thought getNoteLetter was trivial (like I did), you forgot about enharmonics. We
+   * have to consider things like "is this note F or E#?" (aka the accidental type).
+   */
+  Letter getNoteLetter(int note);
+ 
+  /*
+   * How many lines/spaces apart is the current note from a reference pitch. This tells
+   * us where to draw the note.
+   */
+  int getLetterDistance(int note, int ref_pitch);
+  int lettersAboveReference(int note_letter, int ref_letter);
+  int lettersBelowReference(int note_letter, int ref_letter);
+  
+  
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (GrandStaffComponent)
+};
+
+
+#endif  // GRANDSTAFFCOMPONENT_H_INCLUDED
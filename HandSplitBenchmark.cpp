@@ -0,0 +1,139 @@
+/*
+ * HandSplitBenchmark.cpp file header.
+ *
+ * Chris Laguna
+ */
+
+#include "HandSplitBenchmark.h"
+#include "NoteRange.h"
+#include <iostream>
+
+/***** Public members *****/
+
+HandSplitBenchmark::HandSplitBenchmark(int n) : num_events(n), num_note_ons(0) {}
+
+int HandSplitBenchmark::run() {
+  generateEvents();
+
+  double estimator_ns = 0.0;
+  double fixed_ns = 0.0;
+  float final_split = 0.f;
+  int estimator_correct = 0;
+  int fixed_correct = 0;
+  for(int pass = 0; pass < NUM_PASSES; pass++) {
+    double ns = replayEstimator(&final_split, &estimator_correct);
+    estimator_ns = pass == 0 ? ns : jmin(estimator_ns, ns);
+    ns = replayFixedSplit(&fixed_correct);
+    fixed_ns = pass == 0 ? ns : jmin(fixed_ns, ns);
+  }
+
+  std::cout << events.size() << " events (" << num_note_ons << " note-ons), fastest of "
+            << NUM_PASSES << " passes" << std::endl;
+  printResult("HandSplitEstimator", estimator_ns, estimator_correct);
+  printResult("Fixed middle C    ", fixed_ns, fixed_correct);
+  std::cout << "Final split: " << String(final_split, 1) << std::endl;
+  return 0;
+}
+
+bool HandSplitBenchmark::runFromCommandLine(const StringArray& args, int* exit_code) {
+  if(!args.contains("--bench-split")) {
+    return false;
+  }
+
+  int events = 100000;
+  int events_idx = args.indexOf("--events");
+  if(events_idx >= 0 && events_idx + 1 < args.size()) {
+    events = jmax(1, args[events_idx + 1].getIntValue());
+  }
+
+  HandSplitBenchmark benchmark(events);
+  *exit_code = benchmark.run();
+  return true;
+}
+
+/***** Private members *****/
+
+void HandSplitBenchmark::generateEvents() {
+  Random random(SEED);
+  int release_step[128];
+  HandSplitEstimator::Hand key_hand[128];
+  for(int note = 0; note < 128; note++) {
+    release_step[note] = -1;
+    key_hand[note] = HandSplitEstimator::LEFT_HAND;
+  }
+
+  events.clear();
+  events.reserve(num_events);
+  num_note_ons = 0;
+  for(int step = 0; (int) events.size() < num_events; step++) {
+    for(int note = 0; note < 128 && (int) events.size() < num_events; note++) {
+      if(release_step[note] == step) {
+        Event event = { note, false, key_hand[note] };
+        events.push_back(event);
+        release_step[note] = -1;
+      }
+    }
+    if((int) events.size() == num_events) {
+      break;
+    }
+
+    // The left hand's centre drifts between F#2 and A#3, the right hand's between D4 and F#5, and
+    // the notes spread five semitones either side, so the two overlap around middle C.
+    double phase = step * 2.0 * double_Pi / DRIFT_PERIOD;
+    HandSplitEstimator::Hand hand = random.nextBool() ? HandSplitEstimator::RIGHT_HAND : HandSplitEstimator::LEFT_HAND;
+    double centre = hand == HandSplitEstimator::RIGHT_HAND ? 70.0 + 8.0 * std::sin(phase * 0.7 + 1.0)
+                                                           : 50.0 + 8.0 * std::sin(phase);
+    int note = jlimit(NoteRange::MIN_NOTE, NoteRange::MAX_NOTE, roundToInt(centre) + random.nextInt(11) - 5);
+    if(release_step[note] >= 0) {
+      // Already down.
+      continue;
+    }
+    Event event = { note, true, hand };
+    events.push_back(event);
+    num_note_ons++;
+    key_hand[note] = hand;
+    release_step[note] = step + 1 + random.nextInt(MAX_HOLD_STEPS);
+  }
+}
+
+double HandSplitBenchmark::replayEstimator(float* final_split, int* num_correct) {
+  HandSplitEstimator estimator;
+  int correct = 0;
+  int64 start_ticks = Time::getHighResolutionTicks();
+  for(size_t i = 0; i < events.size(); i++) {
+    const Event& event = events[i];
+    if(event.note_on) {
+      correct += estimator.noteOn(event.note) == event.hand;
+    }
+    else {
+      estimator.noteOff(event.note);
+    }
+  }
+  int64 ticks = Time::getHighResolutionTicks() - start_ticks;
+
+  *final_split = estimator.getSplit();
+  *num_correct = correct;
+  return ticks * 1.0e9 / (double) Time::getHighResolutionTicksPerSecond() / events.size();
+}
+
+double HandSplitBenchmark::replayFixedSplit(int* num_correct) {
+  int correct = 0;
+  int64 start_ticks = Time::getHighResolutionTicks();
+  for(size_t i = 0; i < events.size(); i++) {
+    const Event& event = events[i];
+    if(event.note_on) {
+      HandSplitEstimator::Hand hand = event.note >= MIDDLE_C ? HandSplitEstimator::RIGHT_HAND : HandSplitEstimator::LEFT_HAND;
+      correct += hand == event.hand;
+    }
+  }
+  int64 ticks = Time::getHighResolutionTicks() - start_ticks;
+
+  *num_correct = correct;
+  return ticks * 1.0e9 / (double) Time::getHighResolutionTicksPerSecond() / events.size();
+}
+
+void HandSplitBenchmark::printResult(const char* name, double ns_per_event, int num_correct) {
+  std::cout << name << ": " << String(ns_per_event, 1) << " ns per event, "
+            << String(100.0 * num_correct / jmax(1, num_note_ons), 1) << "% of note-ons given to the hand that played them"
+            << std::endl;
+}
@@ -0,0 +1,61 @@
+/*
+ * HandSplitBenchmark: Command-line mode that times HandSplitEstimator against the fixed middle C
+ * split it replaced, without opening a window.
+ *
+ * Chris Laguna
+ */
+
+#ifndef HANDSPLITBENCHMARK_H_INCLUDED
+#define HANDSPLITBENCHMARK_H_INCLUDED
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "HandSplitEstimator.h"
+#include <vector>
+
+/*
+ * Generates a repeatable two-handed performance up front: each hand plays notes around a centre
+ * that drifts, so the left hand regularly plays above middle C and the right hand below it, and
+ * every key is held for a random number of steps. The events are then replayed through the
+ * estimator and through a plain "note >= middle C" test, several times each, timing only the
+ * replay. Both print the time per event and how many note-ons went to the hand that played them.
+ */
+class HandSplitBenchmark {
+public:
+  explicit HandSplitBenchmark(int num_events);
+
+  // Runs both replays, prints the results and returns the process exit code.
+  int run();
+
+  /*
+   * Entry point from the application. Handles:
+   *   --bench-split [--events N]
+   * Returns true if the command line asked for the benchmark (in which case |exit_code| is set).
+   */
+  static bool runFromCommandLine(const StringArray& args, int* exit_code);
+
+private:
+  struct Event {
+    int note;
+    bool note_on;
+    HandSplitEstimator::Hand hand;  // The hand that played it.
+  };
+
+  static const int SEED = 1234;
+  static const int NUM_PASSES = 10;    // The fastest pass is reported.
+  static const int MAX_HOLD_STEPS = 8;
+  static const int DRIFT_PERIOD = 500;  // Steps for each hand's centre to drift up and back.
+  static const int MIDDLE_C = 60;
+
+  int num_events;
+  std::vector<Event> events;
+  int num_note_ons;
+
+  void generateEvents();
+  double replayEstimator(float* final_split, int* num_correct);
+  double replayFixedSplit(int* num_correct);
+  void printResult(const char* name, double ns_per_event, int num_correct);
+
+  JUCE_DECLARE_NON_COPYABLE (HandSplitBenchmark)
+};
+
+#endif  // HANDSPLITBENCHMARK_H_INCLUDED
@@ -0,0 +1,122 @@
+/*
+ * HandSplitEstimator.cpp file header.
+ *
+ * Chris Laguna
+ */
+
+#include "HandSplitEstimator.h"
+
+/***** Public members *****/
+
+HandSplitEstimator::HandSplitEstimator() : num_keys_down(0), lowest_key_down(-1), highest_key_down(-1) {
+  for(int note = 0; note < 128; note++) {
+    key_down[note] = false;
+  }
+  reset();
+}
+
+HandSplitEstimator::Hand HandSplitEstimator::noteOn(int note) {
+  if(!key_down[note]) {
+    key_down[note] = true;
+    num_keys_down++;
+    if(lowest_key_down < 0 || note < lowest_key_down) {
+      lowest_key_down = note;
+    }
+    if(note > highest_key_down) {
+      highest_key_down = note;
+    }
+  }
+  bool clustered = splitHeldNotes();
+
+  Hand hand = note >= split ? RIGHT_HAND : LEFT_HAND;
+  updateAverages(hand, note);
+  if(!clustered) {
+    float target = jlimit(LOWEST_SPLIT, HIGHEST_SPLIT, (left_hand + right_hand) / 2.f);
+    if(std::abs(target - split) > HYSTERESIS) {
+      split = target;
+    }
+  }
+  return hand;
+}
+
+void HandSplitEstimator::noteOff(int note) {
+  if(!key_down[note]) {
+    return;
+  }
+  key_down[note] = false;
+  num_keys_down--;
+  if(num_keys_down == 0) {
+    lowest_key_down = -1;
+    highest_key_down = -1;
+    return;
+  }
+  if(note == lowest_key_down) {
+    while(!key_down[lowest_key_down]) {
+      lowest_key_down++;
+    }
+  }
+  if(note == highest_key_down) {
+    while(!key_down[highest_key_down]) {
+      highest_key_down--;
+    }
+  }
+}
+
+float HandSplitEstimator::getSplit() const {
+  return split;
+}
+
+void HandSplitEstimator::reset() {
+  left_hand = INITIAL_LEFT_HAND;
+  right_hand = INITIAL_RIGHT_HAND;
+  split = (left_hand + right_hand) / 2.f;
+}
+
+/***** Private members *****/
+
+bool HandSplitEstimator::splitHeldNotes() {
+  if(num_keys_down < 2 || highest_key_down - lowest_key_down <= HAND_SPAN) {
+    return false;
+  }
+
+  int previous = lowest_key_down;
+  int gap_low = -1;
+  int gap_high = -1;
+  float best_score = 0.f;
+  for(int note = lowest_key_down + 1; note <= highest_key_down; note++) {
+    if(!key_down[note]) {
+      continue;
+    }
+    float score = (note - previous) - SPLIT_PULL * std::abs((note + previous) / 2.f - split);
+    if(gap_low < 0 || score > best_score) {
+      best_score = score;
+      gap_low = previous;
+      gap_high = note;
+    }
+    previous = note;
+  }
+
+  if(split <= gap_low || split > gap_high) {
+    split = (gap_low + gap_high) / 2.f;
+  }
+  return true;
+}
+
+void HandSplitEstimator::updateAverages(Hand hand, int note) {
+  if(hand == RIGHT_HAND) {
+    right_hand += SMOOTHING * (note - right_hand);
+  }
+  else {
+    left_hand += SMOOTHING * (note - left_hand);
+  }
+
+  // A hand crossing over the other drags it along, rather than the two swapping.
+  if(right_hand - left_hand < MIN_HAND_GAP) {
+    if(hand == RIGHT_HAND) {
+      left_hand = right_hand - MIN_HAND_GAP;
+    }
+    else {
+      right_hand = left_hand + MIN_HAND_GAP;
+    }
+  }
+}
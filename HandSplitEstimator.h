@@ -0,0 +1,80 @@
+/*
+ * HandSplitEstimator: Guesses which hand played each note, to pick the staff it goes on.
+ *
+ * Chris Laguna
+ */
+
+#ifndef HANDSPLITESTIMATOR_H_INCLUDED
+#define HANDSPLITESTIMATOR_H_INCLUDED
+
+#include "../JuceLibraryCode/JuceHeader.h"
+
+/*
+ * Splits the keys that are down into the two hands. Once they spread wider than one hand can
+ * reach (HAND_SPAN), the hands are taken to be the notes either side of the widest gap between
+ * neighbouring keys, with gaps near the current split favoured so the split doesn't jump between
+ * two gaps of about the same size. The split only moves when it isn't already in that gap.
+ *
+ * While the keys that are down fit under one hand (or none are down), the split falls back on a
+ * moving average of where each hand has been playing: halfway between the two, moving only once
+ * it is off by more than HYSTERESIS semitones and staying within a few notes of middle C. A note
+ * at or above the split is the right hand's, and moves the right hand's average towards it
+ * (likewise for the left hand), so the fallback follows a left hand playing above middle C or a
+ * right hand playing below it.
+ *
+ * The keys down are a 128 entry array, with the lowest and highest key down kept as they change,
+ * so the gaps are only looked for once the keys are spread wider than HAND_SPAN. Then a note-on
+ * scans the keys from the lowest to the highest, and letting go of the lowest or highest key
+ * scans for the next one: up to 128 entries per event, whatever has been played before.
+ */
+class HandSplitEstimator {
+public:
+  enum Hand {
+    LEFT_HAND,
+    RIGHT_HAND
+  };
+
+  HandSplitEstimator();
+
+  // Which hand |note| belongs to. Updates that hand's average.
+  Hand noteOn(int note);
+  void noteOff(int note);
+
+  // Notes at or above this go to the right hand.
+  float getSplit() const;
+
+  // Forgets where the hands have been, e.g. for a new input device. The keys that are down are
+  // kept, since they still get their noteOff.
+  void reset();
+
+private:
+  const float INITIAL_LEFT_HAND = 48.f;   // C3
+  const float INITIAL_RIGHT_HAND = 72.f;  // C5
+  const float LOWEST_SPLIT = 53.f;        // F3
+  const float HIGHEST_SPLIT = 67.f;       // G4
+  const float HYSTERESIS = 2.f;           // Semitones.
+  const float MIN_HAND_GAP = 7.f;         // The hands' averages are kept at least this far apart.
+
+  // How much each note moves its hand's average. About the last 1 / SMOOTHING notes count.
+  const float SMOOTHING = 0.15f;
+
+  const int HAND_SPAN = 12;        // Widest a single hand is assumed to reach, in semitones.
+  const float SPLIT_PULL = 0.25f;  // Semitones of gap a gap's midpoint being one semitone further
+                                   // from the current split is worth.
+
+  float left_hand;   // Moving averages of the notes each hand played.
+  float right_hand;
+  float split;
+
+  bool key_down[128];
+  int num_keys_down;
+  int lowest_key_down;   // -1 while no keys are down.
+  int highest_key_down;
+
+  bool splitHeldNotes();  // Moves the split into the widest gap. False if the keys fit one hand.
+  void updateAverages(Hand hand, int note);
+
+  JUCE_DECLARE_NON_COPYABLE (HandSplitEstimator)
+};
+
+#endif  // HANDSPLITESTIMATOR_H_INCLUDED
@@ -0,0 +1,193 @@
+/*
+ * InputLatencyBenchmark.cpp file header.
+ *
+ * Chris Laguna
+ */
+
+#include "InputLatencyBenchmark.h"
+
+#if JUCE_LINUX
+
+#include "AlsaSequencerInput.h"
+#include "NoteStateModel.h"
+#include <alsa/asoundlib.h>
+#include <algorithm>
+#include <iostream>
+
+namespace {
+  const char* const PORT_NAME = "Input latency benchmark";
+}
+
+/***** Receiver *****/
+
+// Stands in for MainContentComponent: updates a NoteStateModel, then records how long it took.
+class InputLatencyBenchmark::Receiver : public MidiInputCallback {
+public:
+  Receiver(InputLatencyBenchmark& o) : owner(o), latencies_us(o.num_events, -1.0), last_event(-1) {}
+
+  void handleIncomingMidiMessage(MidiInput* source, const MidiMessage& message) override {
+    note_state.processMidiMessage(message);
+    if(!message.isNoteOn()) {
+      return;
+    }
+
+    int64 ticks = Time::getHighResolutionTicks() - owner.send_ticks.load();
+    int event = owner.current_event.load();
+    if(message.getNoteNumber() != getNote(event)) {
+      return;  // Arrived after its timeout.
+    }
+    latencies_us[event] = ticks * 1.0e6 / (double) Time::getHighResolutionTicksPerSecond();
+    last_event.store(event, std::memory_order_release);
+  }
+
+  InputLatencyBenchmark& owner;
+  NoteStateModel note_state;
+  std::vector<double> latencies_us;  // -1 for events that never arrived.
+  std::atomic<int> last_event;
+
+  JUCE_DECLARE_NON_COPYABLE (Receiver)
+};
+
+/***** Public members *****/
+
+InputLatencyBenchmark::InputLatencyBenchmark(int n) : num_events(n), seq(nullptr), port(-1),
+    current_event(0), send_ticks(0) {}
+
+InputLatencyBenchmark::~InputLatencyBenchmark() {
+  if(seq != nullptr) {
+    snd_seq_close(seq);
+  }
+}
+
+int InputLatencyBenchmark::run() {
+  if(!openSequencer()) {
+    std::cerr << "Could not open the ALSA sequencer" << std::endl;
+    return 1;
+  }
+
+  // The ALSA input, connected with the sequencer API, at the priority the app asks for.
+  Receiver alsa_receiver(*this);
+  AlsaSequencerInput alsa_input(alsa_receiver);
+  if(!alsa_input.start(true)) {
+    std::cerr << "Could not start the ALSA sequencer input" << std::endl;
+    return 1;
+  }
+  StringArray address;
+  address.addTokens(alsa_input.getPortAddress(), ":", "");
+  snd_seq_connect_to(seq, port, address[0].getIntValue(), address[1].getIntValue());
+
+  // JUCE lists sequencer ports as MIDI input devices; opening ours subscribes to it.
+  Receiver juce_receiver(*this);
+  int device_index = MidiInput::getDevices().indexOf(PORT_NAME);
+  ScopedPointer<MidiInput> juce_input(device_index >= 0 ? MidiInput::openDevice(device_index, &juce_receiver) : nullptr);
+  if(juce_input == nullptr) {
+    std::cerr << "Could not open \"" << PORT_NAME << "\" as a JUCE MIDI input" << std::endl;
+    return 1;
+  }
+  juce_input->start();
+
+  std::cout << "Sending " << num_events << " note-ons to both inputs" << std::endl;
+  for(int event = 0; event < num_events; event++) {
+    int note = getNote(event);
+    current_event.store(event);
+    sendNote(true, note);
+
+    double deadline = Time::getMillisecondCounterHiRes() + TIMEOUT_MS;
+    while((alsa_receiver.last_event.load(std::memory_order_acquire) != event
+           || juce_receiver.last_event.load(std::memory_order_acquire) != event)
+          && Time::getMillisecondCounterHiRes() < deadline) {
+      Thread::yield();
+    }
+
+    sendNote(false, note);
+    Thread::sleep(INTERVAL_MS);
+  }
+
+  juce_input->stop();
+  alsa_input.stop();
+
+  printStats("ALSA sequencer input", alsa_receiver);
+  printStats("JUCE MidiInput      ", juce_receiver);
+  return 0;
+}
+
+bool InputLatencyBenchmark::runFromCommandLine(const StringArray& args, int* exit_code) {
+  if(!args.contains("--bench-input")) {
+    return false;
+  }
+
+  int events = 1000;
+  int events_idx = args.indexOf("--events");
+  if(events_idx >= 0 && events_idx + 1 < args.size()) {
+    events = jmax(1, args[events_idx + 1].getIntValue());
+  }
+
+  InputLatencyBenchmark benchmark(events);
+  *exit_code = benchmark.run();
+  return true;
+}
+
+/***** Private members *****/
+
+bool InputLatencyBenchmark::openSequencer() {
+  if(snd_seq_open(&seq, "default", SND_SEQ_OPEN_OUTPUT, 0) < 0) {
+    seq = nullptr;
+    return false;
+  }
+  snd_seq_set_client_name(seq, PORT_NAME);
+  port = snd_seq_create_simple_port(seq, PORT_NAME, SND_SEQ_PORT_CAP_READ | SND_SEQ_PORT_CAP_SUBS_READ,
+                                    SND_SEQ_PORT_TYPE_MIDI_GENERIC | SND_SEQ_PORT_TYPE_APPLICATION);
+  return port >= 0;
+}
+
+void InputLatencyBenchmark::sendNote(bool note_on, int note) {
+  snd_seq_event_t ev;
+  snd_seq_ev_clear(&ev);
+  snd_seq_ev_set_source(&ev, port);
+  snd_seq_ev_set_subs(&ev);
+  snd_seq_ev_set_direct(&ev);
+  if(note_on) {
+    snd_seq_ev_set_noteon(&ev, 0, note, 100);
+  }
+  else {
+    snd_seq_ev_set_noteoff(&ev, 0, note, 0);
+  }
+
+  send_ticks.store(Time::getHighResolutionTicks());
+  snd_seq_event_output_direct(seq, &ev);
+}
+
+void InputLatencyBenchmark::printStats(const char* name, const Receiver& receiver) {
+  std::vector<double> latencies;
+  for(size_t i = 0; i < receiver.latencies_us.size(); i++) {
+    if(receiver.latencies_us[i] >= 0.0) {
+      latencies.push_back(receiver.latencies_us[i]);
+    }
+  }
+  int lost = (int) (receiver.latencies_us.size() - latencies.size());
+  if(latencies.empty()) {
+    std::cout << name << ": no events arrived" << std::endl;
+    return;
+  }
+
+  std::sort(latencies.begin(), latencies.end());
+  double sum = 0.0;
+  double sum_squares = 0.0;
+  for(size_t i = 0; i < latencies.size(); i++) {
+    sum += latencies[i];
+    sum_squares += latencies[i] * latencies[i];
+  }
+  double mean = sum / latencies.size();
+  double jitter = std::sqrt(jmax(0.0, sum_squares / latencies.size() - mean * mean));
+
+  std::cout << name << ": mean " << String(mean, 1) << " us, median "
+            << String(latencies[latencies.size() / 2], 1) << " us, p99 "
+            << String(latencies[latencies.size() * 99 / 100], 1) << " us, max "
+            << String(latencies.back(), 1) << " us, jitter " << String(jitter, 1) << " us";
+  if(lost > 0) {
+    std::cout << ", " << lost << " lost";
+  }
+  std::cout << std::endl;
+}
+
+#endif  // JUCE_LINUX
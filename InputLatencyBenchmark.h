@@ -0,0 +1,67 @@
+/*
+ * InputLatencyBenchmark: Command-line mode that compares the latency and jitter of the ALSA
+ * sequencer input with JUCE's MidiInput, without opening a window.
+ *
+ * Chris Laguna
+ */
+
+#ifndef INPUTLATENCYBENCHMARK_H_INCLUDED
+#define INPUTLATENCYBENCHMARK_H_INCLUDED
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include <atomic>
+
+#if JUCE_LINUX
+
+struct _snd_seq;
+
+/*
+ * Creates a sequencer client with one output port, and listens to it with both inputs at once: an
+ * AlsaSequencerInput connected to it with the sequencer API, and the JUCE MidiInput device for the
+ * port. Each input feeds its own NoteStateModel, the way MainContentComponent does, and the time
+ * is measured right after the model has been updated, from just before the note-on was sent.
+ *
+ * Note-ons go out one at a time; the next one is sent once both inputs have seen the last (or
+ * given up on after TIMEOUT_MS), so the two never queue up behind each other.
+ */
+class InputLatencyBenchmark {
+public:
+  explicit InputLatencyBenchmark(int num_events);
+  ~InputLatencyBenchmark();
+
+  // Sends the events, prints both inputs' statistics and returns the process exit code.
+  int run();
+
+  /*
+   * Entry point from the application. Handles:
+   *   --bench-input [--events N]
+   * Returns true if the command line asked for the benchmark (in which case |exit_code| is set).
+   */
+  static bool runFromCommandLine(const StringArray& args, int* exit_code);
+
+private:
+  class Receiver;
+
+  static const int TIMEOUT_MS = 100;
+  static const int INTERVAL_MS = 2;  // Between one event arriving everywhere and the next.
+
+  int num_events;
+  _snd_seq* seq;
+  int port;
+
+  std::atomic<int> current_event;
+  std::atomic<int64> send_ticks;
+
+  // Consecutive events use different notes, so one that arrives late isn't mistaken for the next.
+  static int getNote(int event) { return 36 + event % 48; }
+
+  bool openSequencer();
+  void sendNote(bool note_on, int note);
+  static void printStats(const char* name, const Receiver& receiver);
+
+  JUCE_DECLARE_NON_COPYABLE (InputLatencyBenchmark)
+};
+
+#endif  // JUCE_LINUX
+
+#endif  // INPUTLATENCYBENCHMARK_H_INCLUDED
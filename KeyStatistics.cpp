@@ -0,0 +1,253 @@
+/*
+ * KeyStatistics.cpp file header.
+ *
+ * Chris Laguna
+ */
+
+#include "KeyStatistics.h"
+
+/***** Public members *****/
+
+KeyStatistics::KeyStatistics() : sequence(0), num_keys_down(0), key_down_sum(0), chord_pending(false),
+    last_counted_chord(0) {
+  for(int note = 0; note < 128; note++) {
+    press_count[note].store(0);
+    held_us[note].store(0);
+    for(int bucket = 0; bucket < NUM_VELOCITY_BUCKETS; bucket++) {
+      velocity_count[note][bucket].store(0);
+    }
+    interval_count[note].store(0);
+    press_time[note] = 0.0;
+    key_down_channels[note] = 0;
+  }
+  for(int chord = 0; chord < NUM_CHORDS; chord++) {
+    chord_count[chord].store(0);
+  }
+  for(int pitch_class = 0; pitch_class < 12; pitch_class++) {
+    pitch_class_count[pitch_class] = 0;
+  }
+}
+
+void KeyStatistics::processMidiMessage(const MidiMessage& message) {
+  if(message.isNoteOn()) {
+    int note = message.getNoteNumber();
+    uint16 channel_bit = (uint16) (1 << (message.getChannel() - 1));
+    beginUpdate();
+
+    increment(press_count[note]);
+    increment(velocity_count[note][message.getVelocity() * NUM_VELOCITY_BUCKETS / 128]);
+
+    // Re-striking a key that is already down doesn't change the set of keys, so it doesn't count
+    // as a new interval or chord.
+    bool was_down = key_down_channels[note] != 0;
+    key_down_channels[note] |= channel_bit;
+    if(was_down) {
+      endUpdate();
+      return;
+    }
+    pitch_class_count[note % 12]++;
+    num_keys_down++;
+    key_down_sum += note;
+    press_time[note] = message.getTimeStamp();
+
+    // Dyads count as intervals, bigger sets of pitch classes as chords.
+    if(num_keys_down == 2) {
+      int other_note = key_down_sum - note;
+      increment(interval_count[abs(note - other_note)]);
+    }
+    int pitch_class_set = getPitchClassSet();
+    int num_pitch_classes = 0;
+    for(int pitch_class = 0; pitch_class < 12; pitch_class++) {
+      num_pitch_classes += (pitch_class_set >> pitch_class) & 1;
+    }
+    if(num_pitch_classes >= MIN_CHORD_SIZE && pitch_class_set != last_counted_chord) {
+      chord_pending = true;
+    }
+
+    endUpdate();
+  }
+  else if(message.isNoteOff()) {
+    int note = message.getNoteNumber();
+    uint16 channel_bit = (uint16) (1 << (message.getChannel() - 1));
+    if(!(key_down_channels[note] & channel_bit)) {
+      return;
+    }
+    key_down_channels[note] &= (uint16) ~channel_bit;
+    if(key_down_channels[note] != 0) {
+      // Still held on another channel.
+      return;
+    }
+    beginUpdate();
+
+    if(chord_pending) {
+      last_counted_chord = getPitchClassSet();
+      increment(chord_count[last_counted_chord]);
+      chord_pending = false;
+    }
+
+    pitch_class_count[note % 12]--;
+    num_keys_down--;
+    key_down_sum -= note;
+    if(num_keys_down == 0) {
+      last_counted_chord = 0;
+    }
+
+    double held_seconds = jmax(0.0, message.getTimeStamp() - press_time[note]);
+    held_us[note].store(held_us[note].load(std::memory_order_relaxed) + (uint64) (held_seconds * 1.0e6),
+                        std::memory_order_relaxed);
+
+    endUpdate();
+  }
+}
+
+void KeyStatistics::getSnapshot(Snapshot* out) const {
+  for(;;) {
+    uint32 before = sequence.load(std::memory_order_acquire);
+    if(before & 1) {
+      // The writer is in the middle of an update, which takes well under a microsecond.
+      Thread::yield();
+      continue;
+    }
+
+    for(int note = 0; note < 128; note++) {
+      out->press_count[note] = press_count[note].load(std::memory_order_relaxed);
+      out->held_us[note] = held_us[note].load(std::memory_order_relaxed);
+      for(int bucket = 0; bucket < NUM_VELOCITY_BUCKETS; bucket++) {
+        out->velocity_count[note][bucket] = velocity_count[note][bucket].load(std::memory_order_relaxed);
+      }
+    }
+    for(int chord = 0; chord < NUM_CHORDS; chord++) {
+      out->chord_count[chord] = chord_count[chord].load(std::memory_order_relaxed);
+    }
+    for(int interval = 0; interval < NUM_INTERVALS; interval++) {
+      out->interval_count[interval] = interval_count[interval].load(std::memory_order_relaxed);
+    }
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if(sequence.load(std::memory_order_relaxed) == before) {
+      return;
+    }
+  }
+}
+
+bool KeyStatistics::exportSnapshot(const Snapshot& snapshot, const File& file) {
+  DynamicObject::Ptr root = new DynamicObject();
+
+  Array<var> keys;
+  for(int note = 0; note < 128; note++) {
+    if(snapshot.press_count[note] == 0) {
+      continue;
+    }
+    DynamicObject::Ptr key = new DynamicObject();
+    key->setProperty("note", note);
+    key->setProperty("name", MidiMessage::getMidiNoteName(note, true, true, 4));
+    key->setProperty("presses", (int) snapshot.press_count[note]);
+    key->setProperty("held_seconds", snapshot.held_us[note] / 1.0e6);
+    Array<var> velocities;
+    for(int bucket = 0; bucket < NUM_VELOCITY_BUCKETS; bucket++) {
+      velocities.add((int) snapshot.velocity_count[note][bucket]);
+    }
+    key->setProperty("velocity_histogram", velocities);
+    keys.add(var(key.get()));
+  }
+  root->setProperty("keys", keys);
+
+  // The most common chords and intervals. The arrays are small enough to just pick the largest
+  // remaining entry each time.
+  Array<var> chords;
+  Array<int> used_chords;
+  for(int rank = 0; rank < NUM_TOP_ENTRIES; rank++) {
+    int best = -1;
+    for(int chord = 0; chord < NUM_CHORDS; chord++) {
+      if(snapshot.chord_count[chord] > 0 && !used_chords.contains(chord)
+         && (best < 0 || snapshot.chord_count[chord] > snapshot.chord_count[best])) {
+        best = chord;
+      }
+    }
+    if(best < 0) {
+      break;
+    }
+    used_chords.add(best);
+    DynamicObject::Ptr entry = new DynamicObject();
+    entry->setProperty("pitch_classes", getChordName(best));
+    entry->setProperty("count", (int) snapshot.chord_count[best]);
+    chords.add(var(entry.get()));
+  }
+  root->setProperty("top_chords", chords);
+
+  Array<var> intervals;
+  Array<int> used_intervals;
+  for(int rank = 0; rank < NUM_TOP_ENTRIES; rank++) {
+    int best = -1;
+    for(int interval = 0; interval < NUM_INTERVALS; interval++) {
+      if(snapshot.interval_count[interval] > 0 && !used_intervals.contains(interval)
+         && (best < 0 || snapshot.interval_count[interval] > snapshot.interval_count[best])) {
+        best = interval;
+      }
+    }
+    if(best < 0) {
+      break;
+    }
+    used_intervals.add(best);
+    DynamicObject::Ptr entry = new DynamicObject();
+    entry->setProperty("semitones", best);
+    entry->setProperty("name", getIntervalName(best));
+    entry->setProperty("count", (int) snapshot.interval_count[best]);
+    intervals.add(var(entry.get()));
+  }
+  root->setProperty("top_intervals", intervals);
+
+  return file.replaceWithText(JSON::toString(var(root.get())));
+}
+
+/***** Private members *****/
+
+void KeyStatistics::beginUpdate() {
+  sequence.store(sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+}
+
+void KeyStatistics::endUpdate() {
+  sequence.store(sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+void KeyStatistics::increment(std::atomic<uint32>& counter) {
+  // Only the input thread writes, so this doesn't need to be a read-modify-write.
+  counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+int KeyStatistics::getPitchClassSet() const {
+  int pitch_class_set = 0;
+  for(int pitch_class = 0; pitch_class < 12; pitch_class++) {
+    if(pitch_class_count[pitch_class] > 0) {
+      pitch_class_set |= 1 << pitch_class;
+    }
+  }
+  return pitch_class_set;
+}
+
+String KeyStatistics::getChordName(int pitch_class_set) {
+  StringArray names;
+  for(int pitch_class = 0; pitch_class < 12; pitch_class++) {
+    if(pitch_class_set & (1 << pitch_class)) {
+      names.add(MidiMessage::getMidiNoteName(pitch_class, true, false, 4));
+    }
+  }
+  return names.joinIntoString(" ");
+}
+
+String KeyStatistics::getIntervalName(int semitones) {
+  static const char* const names[] = {
+    "unison", "minor 2nd", "major 2nd", "minor 3rd", "major 3rd", "perfect 4th", "tritone",
+    "perfect 5th", "minor 6th", "major 6th", "minor 7th", "major 7th"
+  };
+  int octaves = semitones / 12;
+  String name = names[semitones % 12];
+  if(octaves == 0) {
+    return name;
+  }
+  if(semitones % 12 == 0) {
+    return octaves == 1 ? String("octave") : String(octaves) + " octaves";
+  }
+  return name + " + " + (octaves == 1 ? String("octave") : String(octaves) + " octaves");
+}
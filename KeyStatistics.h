@@ -0,0 +1,82 @@
+/*
+ * KeyStatistics: How each key has been played over the session, and which chords and intervals
+ * come up most.
+ *
+ * Chris Laguna
+ */
+
+#ifndef KEYSTATISTICS_H_INCLUDED
+#define KEYSTATISTICS_H_INCLUDED
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include <atomic>
+
+/*
+ * Accumulated on the MIDI input thread (one writer at a time, like NoteStateModel) into fixed
+ * arrays of relaxed atomics, so the input path never waits. A sequence counter around each update
+ * lets getSnapshot copy a consistent set of counts without pausing the writer: if an update
+ * happened during the copy, it copies again.
+ */
+class KeyStatistics {
+public:
+  static const int NUM_VELOCITY_BUCKETS = 8;  // 16 velocity steps each.
+  static const int NUM_CHORDS = 4096;         // One per set of pitch classes (a 12 bit mask).
+  static const int NUM_INTERVALS = 128;       // Semitones between the two notes of a dyad.
+
+  struct Snapshot {
+    uint32 press_count[128];
+    uint64 held_us[128];  // Only counts notes that have been released.
+    uint32 velocity_count[128][NUM_VELOCITY_BUCKETS];
+    uint32 chord_count[NUM_CHORDS];
+    uint32 interval_count[NUM_INTERVALS];
+  };
+
+  KeyStatistics();
+
+  // Input thread.
+  void processMidiMessage(const MidiMessage& message);
+
+  // Any thread.
+  void getSnapshot(Snapshot* out) const;
+
+  // Writes |snapshot| as JSON, with the most common chords and intervals.
+  static bool exportSnapshot(const Snapshot& snapshot, const File& file);
+
+private:
+  static const int MIN_CHORD_SIZE = 3;  // Distinct pitch classes.
+  static const int NUM_TOP_ENTRIES = 10;
+
+  std::atomic<uint32> sequence;  // Odd while an update is in progress.
+
+  std::atomic<uint32> press_count[128];
+  std::atomic<uint64> held_us[128];
+  std::atomic<uint32> velocity_count[128][NUM_VELOCITY_BUCKETS];
+  std::atomic<uint32> chord_count[NUM_CHORDS];
+  std::atomic<uint32> interval_count[NUM_INTERVALS];
+
+  // Which keys are down, only touched by the input thread. A pitch is down while any channel
+  // holds it, so the same pitch on two channels counts once and lasts until both release it.
+  double press_time[128];         // Message timestamp of the first note-on, in seconds.
+  uint16 key_down_channels[128];  // Bit (channel - 1) for each channel holding the pitch.
+  int pitch_class_count[12];
+  int num_keys_down;              // Distinct pitches.
+  int key_down_sum;               // Sum of the pitches of the keys that are down.
+
+  // A chord is counted once it has settled: on the first note-off after it formed, so rolling it
+  // in or adding a note on the way doesn't count the partial sets. Re-striking a note of the
+  // chord just counted doesn't count it again until every key has been let go.
+  bool chord_pending;
+  int last_counted_chord;  // Pitch class set, 0 once every key is up.
+
+  void beginUpdate();
+  void endUpdate();
+  static void increment(std::atomic<uint32>& counter);
+  int getPitchClassSet() const;
+
+  static String getChordName(int pitch_class_set);
+  static String getIntervalName(int semitones);
+
+  JUCE_DECLARE_NON_COPYABLE (KeyStatistics)
+};
+
+#endif  // KEYSTATISTICS_H_INCLUDED
@@ -1,81 +1,104 @@
-/*
- * Main.cpp: File autogenerated by JUCE containing GUI application skelleton code.
- *
- * Chris Laguna
- */
-
-#include "../JuceLibraryCode/JuceHeader.h"
-#include "MainContentComponent.h"
-
-
-class RealtimeKeyboardNotationApplication : public JUCEApplication {
-    
-public:
-    const String getApplicationName() override       { return ProjectInfo::projectName; }
-    const String getApplicationVersion() override    { return ProjectInfo::versionString; }
-    bool moreThanOneInstanceAllowed() override       { return true; }
-
-    RealtimeKeyboardNotationApplication() {}
-    
-    void initialise(const String& commandLine) override {
-        mainWindow = new MainWindow (getApplicationName());
-    }
-
-    void shutdown() override {
-        mainWindow = nullptr;
-    }
-
-    void systemRequestedQuit() override
-    {
-        // This is called when the app is being asked to quit: you can ignore this
-        // request and let the app carry on running, or call quit() to allow the app to close.
-        quit();
-    }
-
-    void anotherInstanceStarted (const String& commandLine) override
-    {
-        // When another instance of the app is launched while this one is running,
-        // this method is invoked, and the commandLine parameter tells you what
-        // the other instance's command-line arguments were.
-    }
-
-    class MainWindow : public DocumentWindow {
-    private:
-        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MainWindow)
-        
-    public:
-        MainWindow (String name)  : DocumentWindow (name,
-                                                    Colours::lightgrey,
-                                                    DocumentWindow::allButtons)
-        {
-            setUsingNativeTitleBar (true);
-            setContentOwned (new MainContentComponent(), true);
-
-            centreWithSize (getWidth(), getHeight());
-            setVisible (true);
-        }
-
-        void closeButtonPressed() override
-        {
-            // This is called when the user tries to close this window. Here, we'll just
-            // ask the app to quit when this happens, but you can change this to do
-            // whatever you need.
-            JUCEApplication::getInstance()->systemRequestedQuit();
-        }
-
-        /* Note: Be careful if you override any DocumentWindow methods - the base
-           class uses a lot of them, so by overriding you might break its functionality.
-           It's best to do all your work in your content component instead, but if
-           you really have to override any DocumentWindow methods, make sure your
-           subclass also calls the superclass's method.
-        */
-
-    };  // End of class MainWindow.
-
-private:
-    ScopedPointer<MainWindow> mainWindow;
-};  // End of class RealtimeKeyboardNotationApplication.
-
-//==============================================================================
-// This macro generates the main() routine that launches the app.
-START_JUCE_APPLICATION (RealtimeKeyboardNotationApplication)
+/*
+ * Main.cpp: File autogenerated by JUCE containing GUI application skelleton code.
+ *
+ * Chris Laguna
+ */
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "MainContentComponent.h"
+#include "BatchRenderer.h"
+#include "HandSplitBenchmark.h"
+#include "InputLatencyBenchmark.h"
+
+
+class RealtimeKeyboardNotationApplication : public JUCEApplication {
+    
+public:
+    const String getApplicationName() override       { return ProjectInfo::projectName; }
+    const String getApplicationVersion() override    { return ProjectInfo::versionString; }
+    bool moreThanOneInstanceAllowed() override       { return true; }
+
+    RealtimeKeyboardNotationApplication() {}
+    
+    void initialise(const String& commandLine) override {
+        // Batch mode renders MIDI files to images and quits without opening a window.
+        int exit_code = 0;
+        if (BatchRenderer::runFromCommandLine(getCommandLineParameterArray(), &exit_code)) {
+            setApplicationReturnValue(exit_code);
+            quit();
+            return;
+        }
+        if (HandSplitBenchmark::runFromCommandLine(getCommandLineParameterArray(), &exit_code)) {
+            setApplicationReturnValue(exit_code);
+            quit();
+            return;
+        }
+#if JUCE_LINUX
+        if (InputLatencyBenchmark::runFromCommandLine(getCommandLineParameterArray(), &exit_code)) {
+            setApplicationReturnValue(exit_code);
+            quit();
+            return;
+        }
+#endif
+
+        mainWindow = new MainWindow (getApplicationName());
+    }
+
+    void shutdown() override {
+        mainWindow = nullptr;
+    }
+
+    void systemRequestedQuit() override
+    {
+        // This is called when the app is being asked to quit: you can ignore this
+        // request and let the app carry on running, or call quit() to allow the app to close.
+        quit();
+    }
+
+    void anotherInstanceStarted (const String& commandLine) override
+    {
+        // When another instance of the app is launched while this one is running,
+        // this method is invoked, and the commandLine parameter tells you what
+        // the other instance's command-line arguments were.
+    }
+
+    class MainWindow : public DocumentWindow {
+    private:
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MainWindow)
+        
+    public:
+        MainWindow (String name)  : DocumentWindow (name,
+                                                    Colours::lightgrey,
+                                                    DocumentWindow::allButtons)
+        {
+            setUsingNativeTitleBar (true);
+            setContentOwned (new MainContentComponent(), true);
+
+            centreWithSize (getWidth(), getHeight());
+            setVisible (true);
+        }
+
+        void closeButtonPressed() override
+        {
+            // This is called when the user tries to close this window. Here, we'll just
+            // ask the app to quit when this happens, but you can change this to do
+            // whatever you need.
+            JUCEApplication::getInstance()->systemRequestedQuit();
+        }
+
+        /* Note: Be careful if you override any DocumentWindow methods - the base
+           class uses a lot of them, so by overriding you might break its functionality.
+           It's best to do all your work in your content component instead, but if
+           you really have to override any DocumentWindow methods, make sure your
+           subclass also calls the superclass's method.
+        */
+
+    };  // End of class MainWindow.
+
+private:
+    ScopedPointer<MainWindow> mainWindow;
+};  // End of class RealtimeKeyboardNotationApplication.
+
+//==============================================================================
+// This macro generates the main() routine that launches the app.
+START_JUCE_APPLICATION (RealtimeKeyboardNotationApplication)
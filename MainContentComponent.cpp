@@ -1,121 +1,347 @@
-/*
- * MainComponent.cpp file header.
- *
- * Chris Laguna
- */
-
-#include "MainContentComponent.h"
-#include "Callbacks.cpp"
-
-/***** Public members *****/
-
-MainContentComponent::MainContentComponent() : last_input_index(0),
-    keyboard_component(keyboard_state, MidiKeyboardComponent::horizontalKeyboard) {
-  setOpaque(true);
-
-  addAndMakeVisible(midi_input_list);
-  midi_input_list.setTextWhenNoChoicesAvailable("No MIDI Inputs Enabled");
-  const StringArray midi_inputs(MidiInput::getDevices());
-  midi_input_list.addItemList(midi_inputs, 1);
-  midi_input_list.addListener(this);
-  
-  addAndMakeVisible(accidental_mode_list);
-  accidental_mode_list.addItem("All Sharps", ALL_SHARP_ID);
-  accidental_mode_list.addItem("All Flats", ALL_FLAT_ID);
-  accidental_mode_list.setText("All Sharps");
-  accidental_mode_list.addListener(this);
-  
-  
-  // First enabled device is selected by default.
-  for (int i = 0; i < midi_inputs.size(); i++) {
-    if (device_manager.isMidiInputEnabled(midi_inputs[i])) {
-      setMidiInput(i);
-      break;
-    }
-  }
-  
-  // Select first device if none are enabled.
-  if (midi_input_list.getSelectedId() == 0) {
-    setMidiInput(0);
-  }
-  
-  keyboard_component.setAvailableRange(MIN_NOTE, MAX_NOTE);
-  keyboard_component.setColour(MidiKeyboardComponent::keyDownOverlayColourId, Colour(41, 180, 51));
-  addAndMakeVisible(keyboard_component);
-  keyboard_state.addListener(this);
-
-  addAndMakeVisible(grand_staff_component);
-
-  setSize(848, 400);
-}
-
-MainContentComponent::~MainContentComponent() {
-  keyboard_state.removeListener(this);
-  device_manager.removeMidiInputCallback(MidiInput::getDevices()[midi_input_list.getSelectedItemIndex()], this);
-  midi_input_list.removeListener(this);
-}
-
-int MainContentComponent::getMinNote() {
-  return MIN_NOTE;
-}
-
-int MainContentComponent::getMaxNote() {
-  return MAX_NOTE;
-}
-
-void MainContentComponent::paint(Graphics& g) {
-    g.fillAll(Colours::grey);
-}
-
-void MainContentComponent::resized() {
-    Rectangle<int> area(getLocalBounds());
-    accidental_mode_list.setBounds(5, 5, 280, 25);
-    midi_input_list.setBounds(300, 5, 500, 25);
-    keyboard_component.setBounds(5, 35, 832, 80);
-    grand_staff_component.setBounds(5, 130, 832, 250);
-}
-
-/***** Private members *****/
-
-void MainContentComponent::setMidiInput(int index) {
-  const StringArray list(MidiInput::getDevices());
-  
-  device_manager.removeMidiInputCallback(list[last_input_index], this);
-  const String new_input(list[index]);
-  
-  if (!device_manager.isMidiInputEnabled(new_input)) {
-    device_manager.setMidiInputEnabled(new_input, true);
-  }
-  
-  device_manager.addMidiInputCallback(new_input, this);
-  midi_input_list.setSelectedId(index + 1, dontSendNotification);
-  
-  last_input_index = index;
-}
-
-void MainContentComponent::comboBoxChanged(ComboBox* box) {
-  if(box == &midi_input_list) {
-    setMidiInput(midi_input_list.getSelectedItemIndex());
-  }
-  if(box == &accidental_mode_list) {
-    int selected_id = accidental_mode_list.getSelectedId();
-    if(selected_id == ALL_FLAT_ID) {
-      grand_staff_component.setAccidentalMode(ALL_FLATS);
-    }
-    if(selected_id == ALL_SHARP_ID) {
-      grand_staff_component.setAccidentalMode(ALL_SHARPS);
-    }
-  }
-}
-
-void MainContentComponent::handleIncomingMidiMessage(MidiInput* source, const MidiMessage& message) {
-  keyboard_state.processNextMidiEvent(message);
-}
-
-void MainContentComponent::handleNoteOn(MidiKeyboardState*, int midi_channel, int midi_note_number, float velocity) {
-  (new AddNoteCallback(&grand_staff_component, midi_note_number))->post();
-}
-
-void MainContentComponent::handleNoteOff(MidiKeyboardState*, int midi_channel, int midi_note_number, float velocity) {
-  (new RemoveNoteCallback(&grand_staff_component, midi_note_number))->post();
-}
+/*
+ * MainComponent.cpp file header.
+ *
+ * Chris Laguna
+ */
+
+#include "MainContentComponent.h"
+#include "NoteRange.h"
+#include "PaintProfiler.h"
+
+/***** Public members *****/
+
+MainContentComponent::MainContentComponent() : last_input_index(0),
+#if JUCE_LINUX
+    alsa_input(*this),
+#endif
+    keyboard_component(keyboard_state, MidiKeyboardComponent::horizontalKeyboard) {
+  setOpaque(true);
+  PaintProfiler::registerThread("Message thread");
+
+  addAndMakeVisible(midi_input_list);
+  midi_input_list.setTextWhenNoChoicesAvailable("No MIDI Inputs Enabled");
+  const StringArray midi_inputs(MidiInput::getDevices());
+  midi_input_list.addItemList(midi_inputs, 1);
+  midi_input_list.addListener(this);
+  
+  addAndMakeVisible(midi_output_list);
+  midi_output_list.addItem("MIDI Thru Off", THRU_OFF_ID);
+  midi_output_list.addItemList(MidiOutput::getDevices(), THRU_OFF_ID + 1);
+  midi_output_list.setSelectedId(THRU_OFF_ID, dontSendNotification);
+  midi_output_list.addListener(this);
+  
+  addAndMakeVisible(thru_transpose_slider);
+  thru_transpose_slider.setSliderStyle(Slider::IncDecButtons);
+  thru_transpose_slider.setTextBoxStyle(Slider::TextBoxLeft, false, 40, 20);
+  thru_transpose_slider.setRange(-24, 24, 1);
+  thru_transpose_slider.addListener(this);
+  
+  addAndMakeVisible(thru_transpose_label);
+  thru_transpose_label.setText("Transpose", dontSendNotification);
+  thru_transpose_label.attachToComponent(&thru_transpose_slider, true);
+  
+  addAndMakeVisible(thru_latency_label);
+  
+  addAndMakeVisible(accidental_mode_list);
+  accidental_mode_list.addItem("All Sharps", ALL_SHARP_ID);
+  accidental_mode_list.addItem("All Flats", ALL_FLAT_ID);
+  accidental_mode_list.setText("All Sharps");
+  accidental_mode_list.addListener(this);
+  
+  addAndMakeVisible(upper_clef_list);
+  addClefItems(upper_clef_list);
+  upper_clef_list.setSelectedId(TREBLE_CLEF + 1, dontSendNotification);
+  upper_clef_list.addListener(this);
+  
+  addAndMakeVisible(lower_clef_list);
+  addClefItems(lower_clef_list);
+  lower_clef_list.setSelectedId(BASS_CLEF + 1, dontSendNotification);
+  lower_clef_list.addListener(this);
+  
+  addAndMakeVisible(release_time_slider);
+  release_time_slider.setSliderStyle(Slider::LinearHorizontal);
+  release_time_slider.setTextBoxStyle(Slider::TextBoxRight, false, 70, 20);
+  release_time_slider.setRange(0, MAX_RELEASE_TIME_MS, 10);
+  release_time_slider.setTextValueSuffix(" ms");
+  release_time_slider.addListener(this);
+  release_time_slider.setValue(150);
+  
+  addAndMakeVisible(release_time_label);
+  release_time_label.setText("Release fade", dontSendNotification);
+  release_time_label.attachToComponent(&release_time_slider, true);
+  
+  addAndMakeVisible(profile_button);
+  profile_button.setButtonText("Profile paint");
+  profile_button.addListener(this);
+  
+  addAndMakeVisible(heatmap_button);
+  heatmap_button.setButtonText("Heatmap");
+  heatmap_button.addListener(this);
+  
+  addAndMakeVisible(export_statistics_button);
+  export_statistics_button.setButtonText("Export stats");
+  export_statistics_button.addListener(this);
+  
+#if JUCE_LINUX
+  addAndMakeVisible(alsa_input_button);
+  alsa_input_button.setButtonText("ALSA sequencer");
+  alsa_input_button.addListener(this);
+#endif
+  
+  // First enabled device is selected by default.
+  for (int i = 0; i < midi_inputs.size(); i++) {
+    if (device_manager.isMidiInputEnabled(midi_inputs[i])) {
+      setMidiInput(i);
+      break;
+    }
+  }
+  
+  // Select first device if none are enabled.
+  if (midi_input_list.getSelectedId() == 0) {
+    setMidiInput(0);
+  }
+  
+  keyboard_component.setAvailableRange(NoteRange::MIN_NOTE, NoteRange::MAX_NOTE);
+  keyboard_component.setColour(MidiKeyboardComponent::keyDownOverlayColourId, Colour(41, 180, 51));
+  // The keyboard only shows the MIDI input.
+  keyboard_component.setInterceptsMouseClicks(false, false);
+  addAndMakeVisible(keyboard_component);
+
+  addAndMakeVisible(grand_staff_component);
+
+  setSize(848, 490);
+}
+
+MainContentComponent::~MainContentComponent() {
+#if JUCE_LINUX
+  alsa_input.stop();
+  alsa_input_button.removeListener(this);
+#endif
+  cancelPendingUpdate();
+  stopTimer();
+  device_manager.removeMidiInputCallback(MidiInput::getDevices()[midi_input_list.getSelectedItemIndex()], this);
+  midi_input_list.removeListener(this);
+  midi_output_list.removeListener(this);
+  upper_clef_list.removeListener(this);
+  lower_clef_list.removeListener(this);
+  thru_transpose_slider.removeListener(this);
+  release_time_slider.removeListener(this);
+  profile_button.removeListener(this);
+  heatmap_button.removeListener(this);
+  export_statistics_button.removeListener(this);
+}
+
+void MainContentComponent::paint(Graphics& g) {
+    g.fillAll(Colours::grey);
+}
+
+void MainContentComponent::resized() {
+    Rectangle<int> area(getLocalBounds());
+    accidental_mode_list.setBounds(5, 5, 280, 25);
+    midi_input_list.setBounds(300, 5, 500, 25);
+    release_time_slider.setBounds(100, 35, 185, 25);
+    profile_button.setBounds(300, 35, 110, 25);
+#if JUCE_LINUX
+    alsa_input_button.setBounds(420, 35, 200, 25);
+#endif
+    heatmap_button.setBounds(630, 35, 90, 25);
+    export_statistics_button.setBounds(725, 35, 112, 25);
+    midi_output_list.setBounds(5, 65, 280, 25);
+    thru_transpose_slider.setBounds(375, 65, 110, 25);
+    thru_latency_label.setBounds(500, 65, 337, 25);
+    upper_clef_list.setBounds(5, 95, 137, 25);
+    lower_clef_list.setBounds(148, 95, 137, 25);
+    keyboard_component.setBounds(5, 125, 832, 80);
+    grand_staff_component.setBounds(5, 220, 832, 250);
+}
+
+/***** Private members *****/
+
+void MainContentComponent::addClefItems(ComboBox& box) {
+  box.addItem("Treble", TREBLE_CLEF + 1);
+  box.addItem("Bass", BASS_CLEF + 1);
+  box.addItem("Alto", ALTO_CLEF + 1);
+  box.addItem("Tenor", TENOR_CLEF + 1);
+  box.addItem("Treble 8va", TREBLE_8VA_CLEF + 1);
+  box.addItem("Bass 8vb", BASS_8VB_CLEF + 1);
+}
+
+void MainContentComponent::setMidiInput(int index) {
+  const StringArray list(MidiInput::getDevices());
+  
+  device_manager.removeMidiInputCallback(list[last_input_index], this);
+  const String new_input(list[index]);
+  
+  if (!device_manager.isMidiInputEnabled(new_input)) {
+    device_manager.setMidiInputEnabled(new_input, true);
+  }
+  
+#if JUCE_LINUX
+  // While the ALSA reader is on, devices are connected to its port with aconnect instead.
+  if(!alsa_input.isRunning())
+#endif
+  device_manager.addMidiInputCallback(new_input, this);
+  midi_input_list.setSelectedId(index + 1, dontSendNotification);
+  
+  last_input_index = index;
+  // Someone else may be playing the new device.
+  grand_staff_component.resetHandSplit();
+}
+
+void MainContentComponent::setMidiOutput(int index) {
+  MidiOutput* output = index < 0 ? nullptr : MidiOutput::openDevice(index);
+  midi_thru.setOutput(output);
+  midi_thru.resetLatencyStats();
+  if(output == nullptr) {
+    midi_output_list.setSelectedId(THRU_OFF_ID, dontSendNotification);
+    thru_latency_label.setText(String(), dontSendNotification);
+  }
+  updateTimer();
+}
+
+void MainContentComponent::updateThruRules() {
+  MidiThru::RuleSet rules;
+  rules.rules[0].channel = 0;
+  rules.rules[0].lowest_note = 0;
+  rules.rules[0].highest_note = 127;
+  rules.rules[0].transpose = (int) thru_transpose_slider.getValue();
+  rules.num_rules = 1;
+  midi_thru.setRules(rules);
+}
+
+void MainContentComponent::updateTimer() {
+  bool thru_on = midi_output_list.getSelectedId() != THRU_OFF_ID;
+  if(thru_on || heatmap_button.getToggleState()) {
+    startTimer(REFRESH_MS);
+  }
+  else {
+    stopTimer();
+  }
+}
+
+void MainContentComponent::timerCallback() {
+  if(midi_output_list.getSelectedId() != THRU_OFF_ID) {
+    MidiThru::LatencyStats stats = midi_thru.getLatencyStats();
+    thru_latency_label.setText("Thru: " + String(stats.num_messages) + " msgs, mean "
+                               + String(stats.mean_us, 1) + " us, max " + String(stats.max_us, 1) + " us",
+                               dontSendNotification);
+  }
+  if(heatmap_button.getToggleState()) {
+    key_statistics.getSnapshot(&statistics_snapshot);
+    keyboard_component.setHeatmap(statistics_snapshot.press_count);
+  }
+}
+
+void MainContentComponent::comboBoxChanged(ComboBox* box) {
+  if(box == &midi_input_list) {
+    setMidiInput(midi_input_list.getSelectedItemIndex());
+  }
+  if(box == &midi_output_list) {
+    setMidiOutput(midi_output_list.getSelectedId() - THRU_OFF_ID - 1);
+  }
+  if(box == &accidental_mode_list) {
+    int selected_id = accidental_mode_list.getSelectedId();
+    if(selected_id == ALL_FLAT_ID) {
+      grand_staff_component.setAccidentalMode(ALL_FLATS);
+    }
+    if(selected_id == ALL_SHARP_ID) {
+      grand_staff_component.setAccidentalMode(ALL_SHARPS);
+    }
+  }
+  if(box == &upper_clef_list || box == &lower_clef_list) {
+    grand_staff_component.setClefs((ClefType) (upper_clef_list.getSelectedId() - 1),
+                                   (ClefType) (lower_clef_list.getSelectedId() - 1));
+  }
+}
+
+void MainContentComponent::sliderValueChanged(Slider* slider) {
+  if(slider == &release_time_slider) {
+    grand_staff_component.setReleaseTime((int) release_time_slider.getValue());
+  }
+  if(slider == &thru_transpose_slider) {
+    updateThruRules();
+  }
+}
+
+void MainContentComponent::buttonClicked(Button* button) {
+  if(button == &profile_button) {
+    bool profiling = profile_button.getToggleState();
+    PaintProfiler::setEnabled(profiling);
+    if(!profiling) {
+      File trace_file = File::getSpecialLocation(File::userDesktopDirectory)
+          .getNonexistentChildFile("paint_trace", ".json");
+      if(PaintProfiler::writeChromeTrace(trace_file)) {
+        AlertWindow::showMessageBoxAsync(AlertWindow::InfoIcon, "Paint profile",
+                                         "Trace written to " + trace_file.getFullPathName());
+      }
+    }
+  }
+  if(button == &heatmap_button) {
+    if(!heatmap_button.getToggleState()) {
+      keyboard_component.setHeatmap(nullptr);
+    }
+    updateTimer();
+    timerCallback();
+  }
+  if(button == &export_statistics_button) {
+    key_statistics.getSnapshot(&statistics_snapshot);
+    File stats_file = File::getSpecialLocation(File::userDesktopDirectory)
+        .getNonexistentChildFile("key_statistics", ".json");
+    if(KeyStatistics::exportSnapshot(statistics_snapshot, stats_file)) {
+      AlertWindow::showMessageBoxAsync(AlertWindow::InfoIcon, "Key statistics",
+                                       "Statistics written to " + stats_file.getFullPathName());
+    }
+  }
+#if JUCE_LINUX
+  if(button == &alsa_input_button) {
+    setAlsaInputEnabled(alsa_input_button.getToggleState());
+  }
+#endif
+}
+
+#if JUCE_LINUX
+void MainContentComponent::setAlsaInputEnabled(bool enabled) {
+  if(enabled) {
+    // Stop listening through JUCE first, so messages don't arrive twice.
+    device_manager.removeMidiInputCallback(MidiInput::getDevices()[last_input_index], this);
+    if(alsa_input.start(true)) {
+      alsa_input_button.setButtonText("ALSA sequencer " + alsa_input.getPortAddress());
+      grand_staff_component.resetHandSplit();
+      return;
+    }
+    alsa_input_button.setToggleState(false, dontSendNotification);
+  }
+  else if(alsa_input.isRunning()) {
+    AlsaSequencerInput::LatencyStats stats = alsa_input.getLatencyStats();
+    alsa_input.stop();
+    AlertWindow::showMessageBoxAsync(AlertWindow::InfoIcon, "ALSA sequencer latency",
+                                     String(stats.num_events) + " events\n"
+                                     + "mean " + String(stats.mean_us, 1) + " us\n"
+                                     + "max " + String(stats.max_us, 1) + " us\n"
+                                     + "jitter " + String(stats.jitter_us, 1) + " us");
+  }
+
+  alsa_input_button.setButtonText("ALSA sequencer");
+  setMidiInput(last_input_index);
+}
+#endif
+
+void MainContentComponent::handleIncomingMidiMessage(MidiInput* source, const MidiMessage& message) {
+  PAINT_PROFILE_SCOPE("handleIncomingMidiMessage");
+  // Forward before anything else.
+  midi_thru.forward(message);
+  key_statistics.processMidiMessage(message);
+  if(note_state.processMidiMessage(message)) {
+    triggerAsyncUpdate();
+  }
+}
+
+void MainContentComponent::handleAsyncUpdate() {
+  PAINT_PROFILE_SCOPE("handleAsyncUpdate");
+  if(!note_state.acquireSnapshot()) {
+    return;
+  }
+  const NoteSnapshot& snapshot = note_state.getSnapshot();
+  grand_staff_component.setSnapshot(snapshot);
+  keyboard_component.setSnapshot(snapshot);
+}
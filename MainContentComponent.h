@@ -1,65 +1,126 @@
-/*
- * MainContentComponent: The highest level component. Also accepts MIDI messages.
- *
- * Chris Laguna
- */
-
-#ifndef MAINCOMPONENT_H_INCLUDED
-#define MAINCOMPONENT_H_INCLUDED
-
-#include "../JuceLibraryCode/JuceHeader.h"
-#include "GrandStaffComponent.h"
-
-class MainContentComponent : public Component,
-                             private ComboBox::Listener,
-                             private MidiInputCallback,
-                             private MidiKeyboardStateListener {
-public:
-  MainContentComponent();
-  virtual ~MainContentComponent();
-
-  void paint (Graphics&) override;
-  void resized() override;
-  
-  static int getMinNote();
-  static int getMaxNote();
-
-private:
-  // Accidental types (see GrandStaffComponent.h)
-  static const int ALL_SHARP_ID = 1;
-  static const int ALL_FLAT_ID = 2;
-  ComboBox accidental_mode_list;
-  
-  // For managing MIDI input device.
-  AudioDeviceManager device_manager;
-  ComboBox midi_input_list;
-  Label midi_input_list_label;
-  int last_input_index;
-  
-  // JUCE has a built-in keyboard component!
-  MidiKeyboardState keyboard_state;
-  MidiKeyboardComponent keyboard_component;
-  
-  // 88-key keyboard range.
-  static const int MIN_NOTE = 21;
-  static const int MAX_NOTE = 108;
-  
-  // For displaying staff notation.
-  GrandStaffComponent grand_staff_component;
-  
-  // Select which MIDI input should we be listening to.
-  void setMidiInput(int index);
-
-  // Combobox event callbacks.
-  void comboBoxChanged(ComboBox* box) override;
-  
-  // MIDI event callbacks.
-  void handleIncomingMidiMessage(MidiInput* source, const MidiMessage& message) override;
-  void handleNoteOn(MidiKeyboardState*, int midi_channel, int midi_note_number, float velocity) override;
-  void handleNoteOff(MidiKeyboardState*, int midi_channel, int midi_note_number, float velocity) override;
-  
-  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MainContentComponent)
-};
-
-
-#endif  // MAINCOMPONENT_H_INCLUDED
+/*
+ * MainContentComponent: The highest level component. Also accepts MIDI messages.
+ *
+ * Chris Laguna
+ */
+
+#ifndef MAINCOMPONENT_H_INCLUDED
+#define MAINCOMPONENT_H_INCLUDED
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "GrandStaffComponent.h"
+#include "AlsaSequencerInput.h"
+#include "NoteStateModel.h"
+#include "NotationKeyboardComponent.h"
+#include "MidiThru.h"
+#include "KeyStatistics.h"
+
+class MainContentComponent : public Component,
+                             private ComboBox::Listener,
+                             private Slider::Listener,
+                             private Button::Listener,
+                             private MidiInputCallback,
+                             private AsyncUpdater,
+                             private Timer {
+public:
+  MainContentComponent();
+  virtual ~MainContentComponent();
+
+  void paint (Graphics&) override;
+  void resized() override;
+
+private:
+  // Accidental types (see GrandStaffComponent.h)
+  static const int ALL_SHARP_ID = 1;
+  static const int ALL_FLAT_ID = 2;
+  ComboBox accidental_mode_list;
+  
+  // Clefs of the two staves. Item ids are ClefType + 1.
+  ComboBox upper_clef_list;
+  ComboBox lower_clef_list;
+  static void addClefItems(ComboBox& box);
+  
+  // For managing MIDI input device.
+  AudioDeviceManager device_manager;
+  ComboBox midi_input_list;
+  Label midi_input_list_label;
+  int last_input_index;
+  
+#if JUCE_LINUX
+  // Reads the ALSA sequencer directly instead of the device selected in |midi_input_list|.
+  ToggleButton alsa_input_button;
+  AlsaSequencerInput alsa_input;
+  void setAlsaInputEnabled(bool enabled);
+#endif
+  
+  /*
+   * Forwards the input to |midi_output_list|'s device on the input thread, transposed by
+   * |thru_transpose_slider|. While it is on, a timer shows the time forwarding takes.
+   */
+  MidiThru midi_thru;
+  ComboBox midi_output_list;
+  static const int THRU_OFF_ID = 1;
+  Slider thru_transpose_slider;
+  Label thru_transpose_label;
+  Label thru_latency_label;
+  void setMidiOutput(int index);  // -1 turns forwarding off.
+  void updateThruRules();
+  
+  // Session statistics, accumulated on the input thread. The heatmap is refreshed by the timer.
+  KeyStatistics key_statistics;
+  KeyStatistics::Snapshot statistics_snapshot;
+  ToggleButton heatmap_button;
+  TextButton export_statistics_button;
+  
+  // Runs while thru or the heatmap is on.
+  static const int REFRESH_MS = 250;
+  void updateTimer();
+  void timerCallback() override;
+  
+  // How long released notes take to fade out on the staff.
+  Slider release_time_slider;
+  Label release_time_label;
+  static const int MAX_RELEASE_TIME_MS = 1000;
+  
+  // Records paint and MIDI handling timings while on. Turning it off writes a Chrome trace.
+  ToggleButton profile_button;
+  
+  /*
+   * Fed on the MIDI input thread (JUCE's, or the ALSA input's drain thread; only one of them is
+   * active at a time). Every change wakes up the message thread, which pulls the latest snapshot
+   * and passes it on to the keyboard and the staff. A wake-up that is already pending isn't posted
+   * again.
+   */
+  NoteStateModel note_state;
+  
+  // JUCE has a built-in keyboard component! We draw the keys from |note_state| on top of it,
+  // so |keyboard_state| is never fed.
+  MidiKeyboardState keyboard_state;
+  NotationKeyboardComponent keyboard_component;
+  
+  // For displaying staff notation.
+  GrandStaffComponent grand_staff_component;
+  
+  // Select which MIDI input should we be listening to.
+  void setMidiInput(int index);
+
+  // Combobox event callbacks.
+  void comboBoxChanged(ComboBox* box) override;
+  
+  // Slider event callbacks.
+  void sliderValueChanged(Slider* slider) override;
+  
+  // Button event callbacks.
+  void buttonClicked(Button* button) override;
+  
+  // MIDI event callbacks.
+  void handleIncomingMidiMessage(MidiInput* source, const MidiMessage& message) override;
+  
+  // Note state callback, on the message thread.
+  void handleAsyncUpdate() override;
+  
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MainContentComponent)
+};
+
+
+#endif  // MAINCOMPONENT_H_INCLUDED
@@ -0,0 +1,183 @@
+/*
+ * MidiThru.cpp file header.
+ *
+ * Chris Laguna
+ */
+
+#include "MidiThru.h"
+
+/***** Public members *****/
+
+MidiThru::MidiThru() : output(nullptr), forwarding(false), reset_sent_notes_requested(false),
+    num_forwarded(0), latency_sum_ticks(0), latency_max_ticks(0), reset_stats_requested(false) {
+  memset(sent_notes, -1, sizeof(sent_notes));
+
+  // Forward everything unchanged until told otherwise.
+  RuleSet rules;
+  rules.rules[0].channel = 0;
+  rules.rules[0].lowest_note = 0;
+  rules.rules[0].highest_note = 127;
+  rules.rules[0].transpose = 0;
+  rules.num_rules = 1;
+  setRules(rules);
+}
+
+MidiThru::~MidiThru() {
+  setOutput(nullptr);
+}
+
+void MidiThru::setOutput(MidiOutput* new_output) {
+  // Set before the new output is visible, so forward() clears the old device's notes before it
+  // sends anything to the new one.
+  reset_sent_notes_requested.store(true);
+  MidiOutput* old_output = output.exchange(new_output);
+
+  // forward() sets |forwarding| before it loads |output|, so once this is false it can't be
+  // holding on to |old_output|.
+  while(forwarding.load()) {
+    Thread::yield();
+  }
+  if(old_output != nullptr) {
+    // Anything still sounding on it would otherwise never get its note-off.
+    for(int channel = 1; channel <= 16; channel++) {
+      old_output->sendMessageNow(MidiMessage::allNotesOff(channel));
+    }
+  }
+  delete old_output;
+}
+
+void MidiThru::setRules(const RuleSet& new_rules) {
+  rule_sets.getWriteBuffer() = new_rules;
+  rule_sets.publish();
+}
+
+void MidiThru::forward(const MidiMessage& message) {
+  int64 start_ticks = Time::getHighResolutionTicks();
+
+  forwarding.store(true);
+  MidiOutput* out = output.load();
+  if(reset_sent_notes_requested.exchange(false)) {
+    // The old output has been sent All Notes Off; nothing started there needs a note-off here.
+    memset(sent_notes, -1, sizeof(sent_notes));
+  }
+  if(out == nullptr) {
+    forwarding.store(false);
+    return;
+  }
+
+  rule_sets.acquireLatest();
+  const RuleSet& rules = rule_sets.getReadBuffer();
+
+  if(message.isNoteOn()) {
+    startNote(out, rules, message);
+  }
+  else if(message.isNoteOff() || message.isAftertouch()) {
+    followNote(out, message);
+  }
+  else {
+    // Controllers, pitch bend etc. go out once if any rule wants their channel.
+    for(int i = 0; i < rules.num_rules; i++) {
+      if(matches(rules.rules[i], message)) {
+        out->sendMessageNow(message);
+        break;
+      }
+    }
+  }
+  forwarding.store(false, std::memory_order_release);
+
+  recordLatency(start_ticks);
+}
+
+void MidiThru::handleIncomingMidiMessage(MidiInput* source, const MidiMessage& message) {
+  forward(message);
+}
+
+MidiThru::LatencyStats MidiThru::getLatencyStats() const {
+  LatencyStats stats = { 0, 0.0, 0.0 };
+  int64 count = num_forwarded.load(std::memory_order_relaxed);
+  if(count == 0 || reset_stats_requested.load(std::memory_order_relaxed)) {
+    return stats;
+  }
+
+  double ticks_to_us = 1.0e6 / (double) Time::getHighResolutionTicksPerSecond();
+  stats.num_messages = (int) count;
+  stats.mean_us = latency_sum_ticks.load(std::memory_order_relaxed) * ticks_to_us / count;
+  stats.max_us = latency_max_ticks.load(std::memory_order_relaxed) * ticks_to_us;
+  return stats;
+}
+
+void MidiThru::resetLatencyStats() {
+  // The input thread clears the totals before it next adds to them.
+  reset_stats_requested.store(true, std::memory_order_relaxed);
+}
+
+/***** Private members *****/
+
+bool MidiThru::matches(const MidiThruRule& rule, const MidiMessage& message) const {
+  int channel = message.getChannel();
+  if(channel == 0) {
+    // System messages aren't on a channel; every rule passes them.
+    return true;
+  }
+  if(rule.channel != 0 && rule.channel != channel) {
+    return false;
+  }
+  if(message.isNoteOnOrOff()) {
+    int note = message.getNoteNumber();
+    return note >= rule.lowest_note && note <= rule.highest_note;
+  }
+  return true;
+}
+
+void MidiThru::startNote(MidiOutput* out, const RuleSet& rules, const MidiMessage& message) {
+  int8* sent = sent_notes[message.getChannel() - 1][message.getNoteNumber()];
+  for(int i = 0; i < MAX_RULES; i++) {
+    int note = -1;
+    if(i < rules.num_rules && matches(rules.rules[i], message)) {
+      note = message.getNoteNumber() + rules.rules[i].transpose;
+      if(note < 0 || note > 127) {
+        note = -1;
+      }
+    }
+    if(sent[i] >= 0 && sent[i] != note) {
+      // Retriggered after the rules changed; end the note the last note-on started.
+      out->sendMessageNow(MidiMessage::noteOff(message.getChannel(), sent[i]));
+    }
+    if(note >= 0) {
+      // Short messages are stored inline, so the copy doesn't allocate.
+      MidiMessage transposed(message);
+      transposed.setNoteNumber(note);
+      out->sendMessageNow(transposed);
+    }
+    sent[i] = (int8) note;
+  }
+}
+
+void MidiThru::followNote(MidiOutput* out, const MidiMessage& message) {
+  int8* sent = sent_notes[message.getChannel() - 1][message.getNoteNumber()];
+  for(int i = 0; i < MAX_RULES; i++) {
+    if(sent[i] < 0) {
+      continue;
+    }
+    MidiMessage transposed(message);
+    transposed.setNoteNumber(sent[i]);
+    out->sendMessageNow(transposed);
+    if(message.isNoteOff()) {
+      sent[i] = -1;
+    }
+  }
+}
+
+void MidiThru::recordLatency(int64 start_ticks) {
+  int64 ticks = Time::getHighResolutionTicks() - start_ticks;
+  if(reset_stats_requested.exchange(false, std::memory_order_relaxed)) {
+    num_forwarded.store(0, std::memory_order_relaxed);
+    latency_sum_ticks.store(0, std::memory_order_relaxed);
+    latency_max_ticks.store(0, std::memory_order_relaxed);
+  }
+  num_forwarded.store(num_forwarded.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  latency_sum_ticks.store(latency_sum_ticks.load(std::memory_order_relaxed) + ticks, std::memory_order_relaxed);
+  if(ticks > latency_max_ticks.load(std::memory_order_relaxed)) {
+    latency_max_ticks.store(ticks, std::memory_order_relaxed);
+  }
+}
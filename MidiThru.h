@@ -0,0 +1,89 @@
+/*
+ * MidiThru: Forwards incoming MIDI to an output device, straight from the input callback.
+ *
+ * Chris Laguna
+ */
+
+#ifndef MIDITHRU_H_INCLUDED
+#define MIDITHRU_H_INCLUDED
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "TripleBuffer.h"
+#include <atomic>
+
+// Which notes to forward, and where to. Messages that aren't notes only check the channel.
+struct MidiThruRule {
+  int channel;       // 1-16, or 0 for any channel.
+  int lowest_note;
+  int highest_note;
+  int transpose;     // Semitones. Notes transposed out of the MIDI range are dropped.
+};
+
+/*
+ * forward() runs on the MIDI input thread, before anything is handed to the message thread, so a
+ * stalled UI doesn't delay the output. Every rule a message matches sends one copy of it, so
+ * rules can be used for splits and layers.
+ *
+ * Note-offs and poly aftertouch follow the note each rule actually sent at note-on, not what the
+ * rules would send now, so changing the rules while notes are held doesn't leave them stuck.
+ *
+ * Nothing on the input thread locks or allocates: rules are published to it through a
+ * TripleBuffer, and the output device is an atomic pointer. When the output is replaced, the
+ * message thread waits for any forward() in progress, then sends All Notes Off on every channel
+ * before deleting the old device.
+ */
+class MidiThru : public MidiInputCallback {
+public:
+  static const int MAX_RULES = 8;
+
+  struct RuleSet {
+    MidiThruRule rules[MAX_RULES];
+    int num_rules;
+  };
+
+  MidiThru();
+  ~MidiThru();
+
+  // Message thread. Takes ownership of |new_output|; nullptr turns forwarding off.
+  void setOutput(MidiOutput* new_output);
+  void setRules(const RuleSet& new_rules);
+
+  // Input thread.
+  void forward(const MidiMessage& message);
+  void handleIncomingMidiMessage(MidiInput* source, const MidiMessage& message) override;
+
+  // Time spent in forward(), from entry until the last copy was handed to the driver.
+  struct LatencyStats {
+    int num_messages;
+    double mean_us;
+    double max_us;
+  };
+  LatencyStats getLatencyStats() const;
+  void resetLatencyStats();
+
+private:
+  std::atomic<MidiOutput*> output;
+  std::atomic<bool> forwarding;  // True while forward() may be using |output|.
+
+  TripleBuffer<RuleSet> rule_sets;
+
+  // Input thread only. For each incoming channel (0-15) and note, the note each rule slot sent
+  // at note-on, or -1.
+  int8 sent_notes[16][128][MAX_RULES];
+  std::atomic<bool> reset_sent_notes_requested;  // Set by setOutput(), cleared by forward().
+
+  // Written only by the input thread; resetLatencyStats() asks it to clear them.
+  std::atomic<int64> num_forwarded;
+  std::atomic<int64> latency_sum_ticks;
+  std::atomic<int64> latency_max_ticks;
+  std::atomic<bool> reset_stats_requested;
+
+  bool matches(const MidiThruRule& rule, const MidiMessage& message) const;
+  void startNote(MidiOutput* out, const RuleSet& rules, const MidiMessage& message);
+  void followNote(MidiOutput* out, const MidiMessage& message);
+  void recordLatency(int64 start_ticks);
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MidiThru)
+};
+
+#endif  // MIDITHRU_H_INCLUDED
@@ -0,0 +1,85 @@
+/*
+ * NotationKeyboardComponent.cpp file header.
+ *
+ * Chris Laguna
+ */
+
+#include "NotationKeyboardComponent.h"
+
+/***** Public members *****/
+
+NotationKeyboardComponent::NotationKeyboardComponent(MidiKeyboardState& state, Orientation orientation)
+    : MidiKeyboardComponent(state, orientation), snapshot(), show_heatmap(false) {
+  for(int note = 0; note < 128; note++) {
+    heat[note] = 0.f;
+  }
+}
+
+NotationKeyboardComponent::~NotationKeyboardComponent() {}
+
+void NotationKeyboardComponent::paint(Graphics& g) {
+  MidiKeyboardComponent::paint(g);
+
+  if(show_heatmap) {
+    for(int note = getRangeStart(); note <= getRangeEnd(); note++) {
+      if(heat[note] > 0.f) {
+        g.setColour(HEATMAP_COLOUR.withAlpha(heat[note] * MAX_HEATMAP_ALPHA));
+        fillKey(g, note);
+      }
+    }
+  }
+
+  // White keys first, so the black keys' overlays end up on top.
+  for(int note = getRangeStart(); note <= getRangeEnd(); note++) {
+    if(snapshot.isSounding(note) && !MidiMessage::isMidiNoteBlack(note)) {
+      drawKeyOverlay(g, note);
+    }
+  }
+  for(int note = getRangeStart(); note <= getRangeEnd(); note++) {
+    if(snapshot.isSounding(note) && MidiMessage::isMidiNoteBlack(note)) {
+      drawKeyOverlay(g, note);
+    }
+  }
+}
+
+void NotationKeyboardComponent::setSnapshot(const NoteSnapshot& new_snapshot) {
+  snapshot = new_snapshot;
+  repaint();
+}
+
+void NotationKeyboardComponent::setHeatmap(const uint32* press_counts) {
+  show_heatmap = press_counts != nullptr;
+  if(show_heatmap) {
+    uint32 max_count = 1;
+    for(int note = 0; note < 128; note++) {
+      max_count = jmax(max_count, press_counts[note]);
+    }
+    for(int note = 0; note < 128; note++) {
+      heat[note] = press_counts[note] / (float) max_count;
+    }
+  }
+  repaint();
+}
+
+/***** Private members *****/
+
+void NotationKeyboardComponent::drawKeyOverlay(Graphics& g, int note) {
+  Colour colour = snapshot.state[note] == NOTE_HELD ? findColour(keyDownOverlayColourId) : PEDAL_COLOUR;
+  float alpha = getVelocityAlpha(snapshot.velocity[note]);
+  g.setColour(colour.withMultipliedAlpha(alpha));
+  fillKey(g, note);
+}
+
+void NotationKeyboardComponent::fillKey(Graphics& g, int note) {
+  RectangleList<float> area(getRectangleForKey(note).toFloat());
+  if(!MidiMessage::isMidiNoteBlack(note)) {
+    // A white key's rectangle runs under its black neighbours; leave those alone. Cutting their
+    // own rectangles out works for every orientation.
+    for(int neighbour = note - 1; neighbour <= note + 1; neighbour += 2) {
+      if(neighbour >= getRangeStart() && neighbour <= getRangeEnd() && MidiMessage::isMidiNoteBlack(neighbour)) {
+        area.subtract(getRectangleForKey(neighbour).toFloat());
+      }
+    }
+  }
+  g.fillRectList(area);
+}
@@ -0,0 +1,49 @@
+/*
+ * NotationKeyboardComponent: The keyboard view. Draws the sounding notes from a NoteSnapshot on
+ * top of JUCE's keyboard component.
+ *
+ * Chris Laguna
+ */
+
+#ifndef NOTATIONKEYBOARDCOMPONENT_H_INCLUDED
+#define NOTATIONKEYBOARDCOMPONENT_H_INCLUDED
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "NoteStateModel.h"
+
+/*
+ * Held keys are drawn in the key-down colour and keys held by a pedal in |pedal_colour|. Both are
+ * more transparent for softer notes. The keys are only drawn from the snapshot, so the
+ * MidiKeyboardState this is constructed with doesn't need to be fed. A usage heatmap can be shown
+ * underneath.
+ */
+class NotationKeyboardComponent : public MidiKeyboardComponent {
+public:
+  NotationKeyboardComponent(MidiKeyboardState& state, Orientation orientation);
+  virtual ~NotationKeyboardComponent();
+
+  void paint(Graphics& g) override;
+
+  void setSnapshot(const NoteSnapshot& new_snapshot);
+
+  // Shades every key by how often it was pressed, relative to the most pressed key. Pass nullptr
+  // to hide the heatmap.
+  void setHeatmap(const uint32* press_counts);
+
+private:
+  NoteSnapshot snapshot;
+
+  bool show_heatmap;
+  float heat[128];  // 0-1.
+  const Colour HEATMAP_COLOUR = Colour(220, 40, 30);
+  const float MAX_HEATMAP_ALPHA = 0.7f;
+
+  const Colour PEDAL_COLOUR = Colour(60, 120, 220);
+
+  void drawKeyOverlay(Graphics& g, int note);
+  void fillKey(Graphics& g, int note);
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (NotationKeyboardComponent)
+};
+
+#endif  // NOTATIONKEYBOARDCOMPONENT_H_INCLUDED
@@ -0,0 +1,76 @@
+/*
+ * NotationPluginEditor.cpp file header.
+ *
+ * Chris Laguna
+ */
+
+#include "NotationPluginEditor.h"
+
+#if defined (JucePlugin_Name)
+
+#include "NoteRange.h"
+
+/***** Public members *****/
+
+NotationPluginEditor::NotationPluginEditor(NotationPluginProcessor& p) : AudioProcessorEditor(&p),
+    processor(p), keyboard_component(keyboard_state, MidiKeyboardComponent::horizontalKeyboard) {
+  keyboard_component.setAvailableRange(NoteRange::MIN_NOTE, NoteRange::MAX_NOTE);
+  keyboard_component.setColour(MidiKeyboardComponent::keyDownOverlayColourId, Colour(41, 180, 51));
+  keyboard_component.setInterceptsMouseClicks(false, false);
+  addAndMakeVisible(keyboard_component);
+
+  addAndMakeVisible(grand_staff_component);
+
+  addAndMakeVisible(last_event_label);
+  last_event_label.setColour(Label::textColourId, Colours::white);
+
+  // Show whatever is already sounding; later changes arrive through the timer.
+  showSnapshot();
+  startTimerHz(REFRESH_RATE);
+
+  setSize(842, 375);
+}
+
+NotationPluginEditor::~NotationPluginEditor() {
+  stopTimer();
+}
+
+void NotationPluginEditor::paint(Graphics& g) {
+  g.fillAll(Colours::grey);
+}
+
+void NotationPluginEditor::resized() {
+  last_event_label.setBounds(5, 5, 832, 25);
+  keyboard_component.setBounds(5, 35, 832, 80);
+  grand_staff_component.setBounds(5, 120, 832, 250);
+}
+
+/***** Private members *****/
+
+void NotationPluginEditor::timerCallback() {
+  if(processor.getNoteState().acquireSnapshot()) {
+    showSnapshot();
+  }
+
+  int num_events = processor.readEvents(events, MAX_EVENTS_PER_REFRESH);
+  if(num_events > 0) {
+    const NotationPluginProcessor::TimedEvent& event = events[num_events - 1];
+    String position = "at sample " + String(event.timeline_sample)
+                      + (event.on_host_timeline ? " on the host timeline" : " on the plugin's own clock");
+    double sample_rate = processor.getSampleRate();
+    if(sample_rate > 0.0) {
+      position += " (" + String(event.timeline_sample / sample_rate, 3) + " s)";
+    }
+    last_event_label.setText(MidiMessage(event.data, event.size).getDescription() + " " + position
+                             + ", block offset " + String(event.sample_offset),
+                             dontSendNotification);
+  }
+}
+
+void NotationPluginEditor::showSnapshot() {
+  const NoteSnapshot& snapshot = processor.getNoteState().getSnapshot();
+  grand_staff_component.setSnapshot(snapshot);
+  keyboard_component.setSnapshot(snapshot);
+}
+
+#endif  // JucePlugin_Name
@@ -0,0 +1,52 @@
+/*
+ * NotationPluginEditor: The plugin's window. The same keyboard and staff views as the app.
+ *
+ * Chris Laguna
+ */
+
+#ifndef NOTATIONPLUGINEDITOR_H_INCLUDED
+#define NOTATIONPLUGINEDITOR_H_INCLUDED
+
+#include "../JuceLibraryCode/JuceHeader.h"
+
+#if defined (JucePlugin_Name)
+
+#include "NotationPluginProcessor.h"
+#include "GrandStaffComponent.h"
+#include "NotationKeyboardComponent.h"
+
+/*
+ * Polls the processor at the display's rate. Polling never blocks the audio thread: snapshots come
+ * through the processor's NoteStateModel and events through its ring.
+ */
+class NotationPluginEditor : public AudioProcessorEditor,
+                             private Timer {
+public:
+  NotationPluginEditor(NotationPluginProcessor& p);
+  ~NotationPluginEditor();
+
+  void paint(Graphics& g) override;
+  void resized() override;
+
+private:
+  static const int REFRESH_RATE = 60;
+  static const int MAX_EVENTS_PER_REFRESH = 256;
+
+  NotationPluginProcessor& processor;
+
+  MidiKeyboardState keyboard_state;  // Never fed; see NotationKeyboardComponent.
+  NotationKeyboardComponent keyboard_component;
+  GrandStaffComponent grand_staff_component;
+  Label last_event_label;  // The most recent event and where it happened on the host's timeline.
+
+  NotationPluginProcessor::TimedEvent events[MAX_EVENTS_PER_REFRESH];
+
+  void timerCallback() override;
+  void showSnapshot();
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (NotationPluginEditor)
+};
+
+#endif  // JucePlugin_Name
+
+#endif  // NOTATIONPLUGINEDITOR_H_INCLUDED
@@ -0,0 +1,158 @@
+/*
+ * NotationPluginProcessor.cpp file header.
+ *
+ * Chris Laguna
+ */
+
+#include "NotationPluginProcessor.h"
+
+#if defined (JucePlugin_Name)
+
+#include "NotationPluginEditor.h"
+
+/***** Public members *****/
+
+NotationPluginProcessor::NotationPluginProcessor() : event_fifo(EVENT_RING_SIZE), samples_processed(0) {}
+
+NotationPluginProcessor::~NotationPluginProcessor() {}
+
+void NotationPluginProcessor::prepareToPlay(double sample_rate, int samples_per_block) {
+  samples_processed = 0;
+}
+
+void NotationPluginProcessor::releaseResources() {}
+
+void NotationPluginProcessor::processBlock(AudioSampleBuffer& buffer, MidiBuffer& midi) {
+  // Inputs pass through; outputs with no matching input would otherwise hold garbage.
+  for(int channel = getTotalNumInputChannels(); channel < getTotalNumOutputChannels(); channel++) {
+    buffer.clear(channel, 0, buffer.getNumSamples());
+  }
+
+  int64 block_start = samples_processed;
+  bool on_host_timeline = getHostPosition(&block_start);
+
+  // The buffer is already in sample order, so the model sees events in the order they play.
+#if JUCE_MAJOR_VERSION >= 6
+  for(const MidiMessageMetadata metadata : midi) {
+    processEvent(metadata.data, metadata.numBytes, metadata.samplePosition, block_start, on_host_timeline);
+  }
+#else
+  MidiBuffer::Iterator it(midi);
+  const uint8* data;
+  int size;
+  int sample_offset;
+  while(it.getNextEvent(data, size, sample_offset)) {
+    processEvent(data, size, sample_offset, block_start, on_host_timeline);
+  }
+#endif
+
+  samples_processed += buffer.getNumSamples();
+}
+
+int NotationPluginProcessor::readEvents(TimedEvent* dest, int max_events) {
+  int start1, size1, start2, size2;
+  event_fifo.prepareToRead(max_events, start1, size1, start2, size2);
+  for(int i = 0; i < size1; i++) {
+    dest[i] = event_ring[start1 + i];
+  }
+  for(int i = 0; i < size2; i++) {
+    dest[size1 + i] = event_ring[start2 + i];
+  }
+  event_fifo.finishedRead(size1 + size2);
+  return size1 + size2;
+}
+
+AudioProcessorEditor* NotationPluginProcessor::createEditor() {
+  return new NotationPluginEditor(*this);
+}
+
+bool NotationPluginProcessor::hasEditor() const {
+  return true;
+}
+
+const String NotationPluginProcessor::getName() const {
+  return JucePlugin_Name;
+}
+
+bool NotationPluginProcessor::acceptsMidi() const {
+  return true;
+}
+
+bool NotationPluginProcessor::producesMidi() const {
+  return false;
+}
+
+double NotationPluginProcessor::getTailLengthSeconds() const {
+  return 0.0;
+}
+
+int NotationPluginProcessor::getNumPrograms() {
+  return 1;
+}
+
+int NotationPluginProcessor::getCurrentProgram() {
+  return 0;
+}
+
+void NotationPluginProcessor::setCurrentProgram(int index) {}
+
+const String NotationPluginProcessor::getProgramName(int index) {
+  return String();
+}
+
+void NotationPluginProcessor::changeProgramName(int index, const String& new_name) {}
+
+void NotationPluginProcessor::getStateInformation(MemoryBlock& dest_data) {}
+
+void NotationPluginProcessor::setStateInformation(const void* data, int size_in_bytes) {}
+
+/***** Private members *****/
+
+bool NotationPluginProcessor::getHostPosition(int64* timeline_sample) {
+  AudioPlayHead* play_head = getPlayHead();
+  if(play_head == nullptr) {
+    return false;
+  }
+#if JUCE_MAJOR_VERSION >= 7
+  Optional<AudioPlayHead::PositionInfo> position = play_head->getPosition();
+  if(!position.hasValue() || !position->getIsPlaying() || !position->getTimeInSamples().hasValue()) {
+    return false;
+  }
+  *timeline_sample = *position->getTimeInSamples();
+#else
+  AudioPlayHead::CurrentPositionInfo position;
+  if(!play_head->getCurrentPosition(position) || !position.isPlaying) {
+    return false;
+  }
+  *timeline_sample = position.timeInSamples;
+#endif
+  return true;
+}
+
+void NotationPluginProcessor::processEvent(const uint8* data, int size, int sample_offset, int64 block_start,
+                                           bool on_host_timeline) {
+  // Only short messages; building a MidiMessage for sysex would allocate.
+  if(size > 3) {
+    return;
+  }
+  note_state.processMidiMessage(MidiMessage(data, size, 0.0));
+
+  int start1, size1, start2, size2;
+  event_fifo.prepareToWrite(1, start1, size1, start2, size2);
+  if(size1 > 0) {
+    TimedEvent& event = event_ring[start1];
+    event.timeline_sample = block_start + sample_offset;
+    event.on_host_timeline = on_host_timeline;
+    event.sample_offset = sample_offset;
+    memcpy(event.data, data, size);
+    event.size = size;
+    event_fifo.finishedWrite(1);
+  }
+}
+
+// This creates new instances of the plugin.
+AudioProcessor* JUCE_CALLTYPE createPluginFilter() {
+  return new NotationPluginProcessor();
+}
+
+#endif  // JucePlugin_Name
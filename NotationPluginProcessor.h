@@ -0,0 +1,85 @@
+/*
+ * NotationPluginProcessor: Plugin version of the app. Shows the MIDI the host sends to the plugin
+ * instead of a hardware input. Audio passes through untouched.
+ *
+ * Chris Laguna
+ */
+
+#ifndef NOTATIONPLUGINPROCESSOR_H_INCLUDED
+#define NOTATIONPLUGINPROCESSOR_H_INCLUDED
+
+#include "../JuceLibraryCode/JuceHeader.h"
+
+// Only built in the plugin project (see README.md); the app's project has no plugin settings.
+#if defined (JucePlugin_Name)
+
+#include "NoteStateModel.h"
+
+/*
+ * processBlock runs on the host's audio thread, so it only touches fixed-size state: events are
+ * fed to a NoteStateModel in sample order, and the model hands snapshots to the editor through
+ * its TripleBuffer. Every event is also pushed into a ring with its position on the host's
+ * timeline (the block's start plus the event's sample offset), so the editor knows exactly when,
+ * relative to playback, each event happened. While the host isn't playing, or doesn't say where
+ * it is, events are stamped with the plugin's own sample count instead, and flagged as such.
+ */
+class NotationPluginProcessor : public AudioProcessor {
+public:
+  NotationPluginProcessor();
+  ~NotationPluginProcessor();
+
+  void prepareToPlay(double sample_rate, int samples_per_block) override;
+  void releaseResources() override;
+  void processBlock(AudioSampleBuffer& buffer, MidiBuffer& midi) override;
+
+  AudioProcessorEditor* createEditor() override;
+  bool hasEditor() const override;
+
+  const String getName() const override;
+  bool acceptsMidi() const override;
+  bool producesMidi() const override;
+  double getTailLengthSeconds() const override;
+
+  int getNumPrograms() override;
+  int getCurrentProgram() override;
+  void setCurrentProgram(int index) override;
+  const String getProgramName(int index) override;
+  void changeProgramName(int index, const String& new_name) override;
+
+  void getStateInformation(MemoryBlock& dest_data) override;
+  void setStateInformation(const void* data, int size_in_bytes) override;
+
+  // One MIDI event, stamped with where it happened on the host's timeline.
+  struct TimedEvent {
+    int64 timeline_sample;  // Position of the block, plus |sample_offset|.
+    bool on_host_timeline;  // Whether |timeline_sample| is the host's position, or the samples
+                            // processed since prepareToPlay.
+    int sample_offset;      // Offset within the block the event arrived in.
+    uint8 data[3];
+    int size;
+  };
+
+  // Editor side. Only one editor reads at a time.
+  NoteStateModel& getNoteState() { return note_state; }
+  int readEvents(TimedEvent* dest, int max_events);
+
+private:
+  static const int EVENT_RING_SIZE = 1024;
+
+  NoteStateModel note_state;
+
+  // Written by the audio thread, read by the editor.
+  AbstractFifo event_fifo;
+  TimedEvent event_ring[EVENT_RING_SIZE];
+
+  int64 samples_processed;  // Used as the timeline position when the host doesn't give one.
+
+  bool getHostPosition(int64* timeline_sample);
+  void processEvent(const uint8* data, int size, int sample_offset, int64 block_start, bool on_host_timeline);
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (NotationPluginProcessor)
+};
+
+#endif  // JucePlugin_Name
+
+#endif  // NOTATIONPLUGINPROCESSOR_H_INCLUDED
@@ -0,0 +1,16 @@
+/*
+ * NoteRange: The MIDI pitches the views show, shared by the app and the plugin.
+ *
+ * Chris Laguna
+ */
+
+#ifndef NOTERANGE_H_INCLUDED
+#define NOTERANGE_H_INCLUDED
+
+// 88-key keyboard range.
+namespace NoteRange {
+  const int MIN_NOTE = 21;
+  const int MAX_NOTE = 108;
+}
+
+#endif  // NOTERANGE_H_INCLUDED
@@ -0,0 +1,156 @@
+/*
+ * NoteStateModel.cpp file header.
+ *
+ * Chris Laguna
+ */
+
+#include "NoteStateModel.h"
+
+/***** Public members *****/
+
+NoteStateModel::NoteStateModel() {
+  for(int note = 0; note < 128; note++) {
+    strike_count[note] = 0;
+  }
+  reset();
+}
+
+bool NoteStateModel::processMidiMessage(const MidiMessage& message) {
+  int channel = message.getChannel();
+  if(channel == 0) {
+    // Not a channel message.
+    return false;
+  }
+  uint16 channel_bit = (uint16) (1 << (channel - 1));
+
+  if(message.isNoteOn()) {
+    int note = message.getNoteNumber();
+    // A retriggered note is held again, whatever the pedals were doing with it.
+    held_channels[note] |= channel_bit;
+    sustained_channels[note] &= ~channel_bit;
+    velocity[note] = message.getVelocity();
+    strike_count[note]++;
+  }
+  else if(message.isNoteOff()) {
+    int note = message.getNoteNumber();
+    if((held_channels[note] & channel_bit) == 0) {
+      // Duplicate note-off.
+      return false;
+    }
+    held_channels[note] &= ~channel_bit;
+    if(sustain_pedal_channels & channel_bit) {
+      sustained_channels[note] |= channel_bit;
+    }
+  }
+  else if(message.isController()) {
+    int controller = message.getControllerNumber();
+    if(controller == SUSTAIN_CC || controller == SOSTENUTO_CC) {
+      setPedal(controller, channel_bit, message.getControllerValue() >= 64);
+    }
+    else if(controller == ALL_SOUND_OFF_CC) {
+      silenceChannel(channel_bit);
+    }
+    else if(controller == ALL_NOTES_OFF_CC) {
+      releaseChannel(channel_bit);
+    }
+    else {
+      return false;
+    }
+  }
+  else {
+    return false;
+  }
+
+  publish();
+  return true;
+}
+
+void NoteStateModel::reset() {
+  for(int note = 0; note < 128; note++) {
+    held_channels[note] = 0;
+    sustained_channels[note] = 0;
+    sostenuto_channels[note] = 0;
+    velocity[note] = 0;
+  }
+  sustain_pedal_channels = 0;
+  sostenuto_pedal_channels = 0;
+  publish();
+}
+
+/***** Private members *****/
+
+void NoteStateModel::setPedal(int controller, uint16 channel_bit, bool down) {
+  uint16& pedal_channels = controller == SUSTAIN_CC ? sustain_pedal_channels : sostenuto_pedal_channels;
+  if(((pedal_channels & channel_bit) != 0) == down) {
+    // Half-pedalling sends lots of values on the same side of 64.
+    return;
+  }
+
+  if(down) {
+    pedal_channels |= channel_bit;
+  }
+  else {
+    pedal_channels &= ~channel_bit;
+  }
+
+  for(int note = 0; note < 128; note++) {
+    if(controller == SUSTAIN_CC) {
+      if(!down) {
+        sustained_channels[note] &= ~channel_bit;
+      }
+    }
+    else {
+      // Sostenuto only catches the notes that are down when it is pressed.
+      if(down) {
+        sostenuto_channels[note] |= held_channels[note] & channel_bit;
+      }
+      else {
+        sostenuto_channels[note] &= ~channel_bit;
+      }
+    }
+  }
+}
+
+void NoteStateModel::releaseChannel(uint16 channel_bit) {
+  // Like a note-off for every key: the pedals keep what they are holding.
+  bool sustain_down = (sustain_pedal_channels & channel_bit) != 0;
+  for(int note = 0; note < 128; note++) {
+    if(sustain_down && (held_channels[note] & channel_bit)) {
+      sustained_channels[note] |= channel_bit;
+    }
+    held_channels[note] &= ~channel_bit;
+  }
+}
+
+void NoteStateModel::silenceChannel(uint16 channel_bit) {
+  for(int note = 0; note < 128; note++) {
+    held_channels[note] &= ~channel_bit;
+    sustained_channels[note] &= ~channel_bit;
+    sostenuto_channels[note] &= ~channel_bit;
+  }
+}
+
+NoteState NoteStateModel::getState(int note) const {
+  if(held_channels[note] != 0) {
+    return NOTE_HELD;
+  }
+  if(sostenuto_channels[note] != 0) {
+    return NOTE_SOSTENUTO;
+  }
+  if(sustained_channels[note] != 0) {
+    return NOTE_SUSTAINED;
+  }
+  return NOTE_RELEASED;
+}
+
+void NoteStateModel::publish() {
+  NoteSnapshot& snapshot = snapshots.getWriteBuffer();
+  for(int note = 0; note < 128; note++) {
+    snapshot.state[note] = (uint8) getState(note);
+    snapshot.velocity[note] = velocity[note];
+    snapshot.strike_count[note] = strike_count[note];
+  }
+  snapshot.sustain_pedal_down = sustain_pedal_channels != 0;
+  snapshot.sostenuto_pedal_down = sostenuto_pedal_channels != 0;
+  snapshots.publish();
+}
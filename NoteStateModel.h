@@ -0,0 +1,91 @@
+/*
+ * NoteStateModel: Which notes are sounding, and why, given the MIDI input so far. Takes the
+ * sustain (CC64) and sostenuto (CC66) pedals, All Sound Off (CC120), All Notes Off (CC123) and
+ * note velocity into account.
+ *
+ * Chris Laguna
+ */
+
+#ifndef NOTESTATEMODEL_H_INCLUDED
+#define NOTESTATEMODEL_H_INCLUDED
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "TripleBuffer.h"
+
+// Why a note is sounding. Held wins over the pedals.
+enum NoteState {
+  NOTE_RELEASED = 0,
+  NOTE_HELD,        // The key is down.
+  NOTE_SUSTAINED,   // The key was released while the sustain pedal was down.
+  NOTE_SOSTENUTO    // The key was down when the sostenuto pedal was pressed, and has since been released.
+};
+
+// Everything the views need to draw one moment of input.
+struct NoteSnapshot {
+  uint8 state[128];     // A NoteState for every MIDI pitch.
+  uint8 velocity[128];  // Velocity of the last note-on for each pitch, kept after it is released.
+  uint16 strike_count[128];  // Note-ons for each pitch so far, wrapping. Catches notes struck and
+                             // released between two reads, which |state| alone would miss.
+  bool sustain_pedal_down;
+  bool sostenuto_pedal_down;
+
+  bool isSounding(int note) const { return state[note] != NOTE_RELEASED; }
+  bool wasStruckSince(const NoteSnapshot& previous, int note) const {
+    return strike_count[note] != previous.strike_count[note];
+  }
+};
+
+// Opacity the views draw a note with, so softer notes are lighter.
+inline float getVelocityAlpha(int velocity) {
+  const float MIN_VELOCITY_ALPHA = 0.35f;  // Opacity of a note played at velocity 0.
+  return MIN_VELOCITY_ALPHA + (1.f - MIN_VELOCITY_ALPHA) * velocity / 127.f;
+}
+
+/*
+ * The state for each key is a bit per MIDI channel, so the same pitch held on two channels is one
+ * note that is released when the last channel lets go, and a duplicate note-on just updates the
+ * velocity. Everything is in fixed arrays; processing a message never allocates or locks.
+ *
+ * processMidiMessage must only be called from one thread at a time (the MIDI input thread). After
+ * each change a new NoteSnapshot is published through a TripleBuffer, which a single other thread
+ * (the message thread) picks up with acquireSnapshot.
+ */
+class NoteStateModel {
+public:
+  NoteStateModel();
+
+  // Input thread. Returns true if a new snapshot was published.
+  bool processMidiMessage(const MidiMessage& message);
+  void reset();
+
+  // Reader thread. Returns true if the snapshot changed since the last call.
+  bool acquireSnapshot() { return snapshots.acquireLatest(); }
+  const NoteSnapshot& getSnapshot() const { return snapshots.getReadBuffer(); }
+
+private:
+  static const int SUSTAIN_CC = 64;
+  static const int SOSTENUTO_CC = 66;
+  static const int ALL_SOUND_OFF_CC = 120;  // Everything on the channel stops.
+  static const int ALL_NOTES_OFF_CC = 123;  // Releases the keys; notes held by a pedal carry on.
+
+  // Bit n is MIDI channel n + 1.
+  uint16 held_channels[128];
+  uint16 sustained_channels[128];
+  uint16 sostenuto_channels[128];
+  uint16 sustain_pedal_channels;
+  uint16 sostenuto_pedal_channels;
+  uint8 velocity[128];
+  uint16 strike_count[128];  // Not cleared by reset(), so the reader never sees a strike that wasn't.
+
+  TripleBuffer<NoteSnapshot> snapshots;
+
+  void setPedal(int controller, uint16 channel_bit, bool down);
+  void releaseChannel(uint16 channel_bit);
+  void silenceChannel(uint16 channel_bit);
+  NoteState getState(int note) const;
+  void publish();
+
+  JUCE_DECLARE_NON_COPYABLE (NoteStateModel)
+};
+
+#endif  // NOTESTATEMODEL_H_INCLUDED
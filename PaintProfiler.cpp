@@ -0,0 +1,225 @@
+/*
+ * PaintProfiler.cpp file header.
+ *
+ * Chris Laguna
+ */
+
+#include "PaintProfiler.h"
+
+std::atomic<bool> PaintProfiler::enabled(false);
+
+/***** ThreadBuffer *****/
+
+/*
+ * Single producer (the owning thread), single consumer (whoever calls writeChromeTrace) ring of
+ * events. A thread that exits leaves its events behind until they are written out, so it doesn't
+ * lose them.
+ */
+class PaintProfiler::ThreadBuffer {
+public:
+  enum State {
+    FREE,
+    CLAIMING,  // A thread is filling in its name.
+    CLAIMED,
+    RELEASED  // The thread has exited, but its events haven't been written out yet.
+  };
+
+  ThreadBuffer() : thread_id(0), num_dropped(0), state(FREE), write_pos(0), read_pos(0) {}
+
+  bool isEmpty() const {
+    return write_pos.load(std::memory_order_acquire) == read_pos.load(std::memory_order_acquire);
+  }
+
+  void push(const Event& event) {
+    uint32 write = write_pos.load(std::memory_order_relaxed);
+    if(write - read_pos.load(std::memory_order_acquire) >= CAPACITY) {
+      num_dropped.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    events[write % CAPACITY] = event;
+    write_pos.store(write + 1, std::memory_order_release);
+  }
+
+  // Hands every event recorded since the last drain to |output|.
+  template <typename Output>
+  void drain(Output& output) {
+    uint32 read = read_pos.load(std::memory_order_relaxed);
+    uint32 write = write_pos.load(std::memory_order_acquire);
+    for(; read != write; read++) {
+      output(events[read % CAPACITY]);
+    }
+    read_pos.store(write, std::memory_order_release);
+  }
+
+  // Set by the claiming thread before |state| becomes CLAIMED. Every claim gets a new id, so a
+  // reused buffer shows up as a new thread in the trace.
+  int thread_id;
+  String thread_name;
+  std::atomic<uint32> num_dropped;
+  std::atomic<int> state;
+
+private:
+  static const uint32 CAPACITY = 16384;
+  Event events[CAPACITY];
+  std::atomic<uint32> write_pos;
+  std::atomic<uint32> read_pos;
+
+  JUCE_DECLARE_NON_COPYABLE (ThreadBuffer)
+};
+
+// Every buffer, allocated up front.
+struct PaintProfiler::BufferRegistry {
+  BufferRegistry() : next_thread_id(1), message_thread_name("Message thread"), unnamed_thread_name("MIDI input") {
+    for(int i = 0; i < MAX_THREADS; i++) {
+      buffers.add(new ThreadBuffer());
+    }
+  }
+
+  OwnedArray<ThreadBuffer> buffers;
+  std::atomic<int> next_thread_id;
+  CriticalSection flush_lock;  // Only one writeChromeTrace drains the buffers at a time.
+
+  // Made up front, so naming a thread's buffer only copies a reference.
+  const String message_thread_name;
+  const String unnamed_thread_name;
+};
+
+struct PaintProfiler::ThreadBufferOwner {
+  ThreadBufferOwner() : buffer(nullptr), tried_to_claim(false) {}
+
+  ~ThreadBufferOwner() {
+    if(buffer == nullptr) {
+      return;
+    }
+    // An empty buffer can be reused straight away; otherwise writeChromeTrace frees it.
+    buffer->state.store(buffer->isEmpty() ? ThreadBuffer::FREE : ThreadBuffer::RELEASED,
+                        std::memory_order_release);
+  }
+
+  ThreadBuffer* buffer;
+  bool tried_to_claim;
+};
+
+thread_local PaintProfiler::ThreadBufferOwner PaintProfiler::thread_owner;
+
+namespace {
+  void writeEscaped(OutputStream& out, const String& text) {
+    out << text.replace("\\", "\\\\").replace("\"", "\\\"");
+  }
+}
+
+/***** Public members *****/
+
+void PaintProfiler::setEnabled(bool should_be_enabled) {
+  getRegistry();
+  enabled.store(should_be_enabled, std::memory_order_relaxed);
+}
+
+void PaintProfiler::registerThread(const String& name) {
+  if(!thread_owner.tried_to_claim) {
+    claimThreadBuffer(name);
+  }
+}
+
+void PaintProfiler::record(const char* name, int64 start_ticks, int64 end_ticks) {
+  if(ThreadBuffer* buffer = getThreadBuffer()) {
+    Event event = { name, start_ticks, end_ticks };
+    buffer->push(event);
+  }
+}
+
+bool PaintProfiler::writeChromeTrace(const File& file) {
+  file.deleteFile();
+  FileOutputStream out(file);
+  if(out.failedToOpen()) {
+    return false;
+  }
+
+  const double ticks_to_us = 1.0e6 / (double) Time::getHighResolutionTicksPerSecond();
+  bool first = true;
+
+  out << "{\"traceEvents\":[\n";
+
+  BufferRegistry& registry = getRegistry();
+  const ScopedLock sl(registry.flush_lock);
+  for(int i = 0; i < MAX_THREADS; i++) {
+    ThreadBuffer* buffer = registry.buffers[i];
+    int state = buffer->state.load(std::memory_order_acquire);
+    if(state == ThreadBuffer::FREE || state == ThreadBuffer::CLAIMING) {
+      continue;
+    }
+
+    // Metadata so the viewer shows thread names instead of numbers.
+    out << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+        << buffer->thread_id << ",\"args\":{\"name\":\"";
+    writeEscaped(out, buffer->thread_name);
+    out << "\"}}";
+    first = false;
+
+    int64 last_ticks = 0;
+    auto write_event = [&out, ticks_to_us, buffer, &last_ticks] (const Event& event) {
+      last_ticks = event.end_ticks;
+      out << ",\n{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->thread_id
+          << ",\"ts\":" << String(event.start_ticks * ticks_to_us, 3)
+          << ",\"dur\":" << String((event.end_ticks - event.start_ticks) * ticks_to_us, 3) << "}";
+    };
+    buffer->drain(write_event);
+
+    // Events are only dropped while the buffer is full, so the marker goes after the last event
+    // that made it.
+    uint32 dropped = last_ticks != 0 ? buffer->num_dropped.exchange(0, std::memory_order_relaxed) : 0;
+    if(dropped > 0) {
+      out << ",\n{\"name\":\"dropped events\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":" << buffer->thread_id
+          << ",\"ts\":" << String(last_ticks * ticks_to_us, 3)
+          << ",\"args\":{\"count\":" << (int) dropped << "}}";
+    }
+
+    if(state == ThreadBuffer::RELEASED) {
+      buffer->state.store(ThreadBuffer::FREE, std::memory_order_release);
+    }
+  }
+
+  out << "\n]}\n";
+  out.flush();
+  return out.getStatus().wasOk();
+}
+
+/***** Private members *****/
+
+PaintProfiler::ThreadBuffer* PaintProfiler::getThreadBuffer() {
+  if(!thread_owner.tried_to_claim) {
+    if(MessageManager::getInstanceWithoutCreating() != nullptr
+       && MessageManager::getInstanceWithoutCreating()->isThisTheMessageThread()) {
+      claimThreadBuffer(getRegistry().message_thread_name);
+    }
+    else if(Thread* thread = Thread::getCurrentThread()) {
+      claimThreadBuffer(thread->getThreadName());
+    }
+    else {
+      claimThreadBuffer(getRegistry().unnamed_thread_name);
+    }
+  }
+  return thread_owner.buffer;
+}
+
+void PaintProfiler::claimThreadBuffer(const String& name) {
+  thread_owner.tried_to_claim = true;
+  BufferRegistry& registry = getRegistry();
+  for(int i = 0; i < MAX_THREADS; i++) {
+    ThreadBuffer* buffer = registry.buffers[i];
+    int expected = ThreadBuffer::FREE;
+    if(buffer->state.compare_exchange_strong(expected, ThreadBuffer::CLAIMING, std::memory_order_acquire)) {
+      buffer->thread_id = registry.next_thread_id.fetch_add(1);
+      buffer->thread_name = name;
+      buffer->num_dropped.store(0, std::memory_order_relaxed);
+      buffer->state.store(ThreadBuffer::CLAIMED, std::memory_order_release);
+      thread_owner.buffer = buffer;
+      return;
+    }
+  }
+}
+
+PaintProfiler::BufferRegistry& PaintProfiler::getRegistry() {
+  static BufferRegistry registry;
+  return registry;
+}
@@ -0,0 +1,85 @@
+/*
+ * PaintProfiler: Scoped timing of the drawing and MIDI handling code, written out as a Chrome
+ * trace so it can be opened in chrome://tracing or https://ui.perfetto.dev.
+ *
+ * Chris Laguna
+ */
+
+#ifndef PAINTPROFILER_H_INCLUDED
+#define PAINTPROFILER_H_INCLUDED
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include <atomic>
+
+/*
+ * Every thread that records an event gets its own fixed-size buffer, which only that thread
+ * writes to. The buffers for up to MAX_THREADS threads are allocated together, the first time the
+ * profiler is enabled or a thread registers. A thread claims a free one with a compare-and-swap
+ * and gives it back when it exits; a buffer that still holds events is only reused once they have
+ * been written out. So recording never locks or allocates, not even a thread's first event, and
+ * threads that come and go (MIDI inputs being reopened) don't use the buffers up. When a buffer is
+ * full, events are dropped until the next flush. When profiling is disabled, a scope costs one
+ * relaxed atomic load.
+ */
+class PaintProfiler {
+public:
+  static void setEnabled(bool should_be_enabled);
+  static bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+
+  /*
+   * Claims a buffer for the calling thread under |name|. Threads that don't call this are named
+   * after their juce::Thread (or as the message thread) when they record their first event.
+   */
+  static void registerThread(const String& name);
+
+  static const int MAX_THREADS = 8;  // Threads beyond this many at once aren't recorded.
+
+  // Called by ScopedPaintTrace. |name| must be a string literal (it is stored as a pointer).
+  static void record(const char* name, int64 start_ticks, int64 end_ticks);
+
+  // Drains every thread's buffer into |file| in the Chrome trace event format.
+  static bool writeChromeTrace(const File& file);
+
+private:
+  struct Event {
+    const char* name;
+    int64 start_ticks;
+    int64 end_ticks;
+  };
+
+  class ThreadBuffer;
+  struct BufferRegistry;
+  struct ThreadBufferOwner;
+  static ThreadBuffer* getThreadBuffer();
+  static void claimThreadBuffer(const String& name);
+  static BufferRegistry& getRegistry();
+
+  // Gives this thread's buffer back when the thread exits.
+  static thread_local ThreadBufferOwner thread_owner;
+
+  static std::atomic<bool> enabled;
+};
+
+// Records the time between its construction and destruction.
+class ScopedPaintTrace {
+public:
+  explicit ScopedPaintTrace(const char* n)
+      : name(PaintProfiler::isEnabled() ? n : nullptr),
+        start_ticks(name != nullptr ? Time::getHighResolutionTicks() : 0) {}
+
+  ~ScopedPaintTrace() {
+    if(name != nullptr) {
+      PaintProfiler::record(name, start_ticks, Time::getHighResolutionTicks());
+    }
+  }
+
+private:
+  const char* name;
+  int64 start_ticks;
+
+  JUCE_DECLARE_NON_COPYABLE (ScopedPaintTrace)
+};
+
+#define PAINT_PROFILE_SCOPE(name) ScopedPaintTrace JUCE_JOIN_MACRO(paint_trace_, __LINE__) (name)
+
+#endif  // PAINTPROFILER_H_INCLUDED
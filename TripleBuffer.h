@@ -0,0 +1,58 @@
+/*
+ * TripleBuffer: Hands the latest version of a value from one thread to another without either
+ * side ever waiting.
+ *
+ * Chris Laguna
+ */
+
+#ifndef TRIPLEBUFFER_H_INCLUDED
+#define TRIPLEBUFFER_H_INCLUDED
+
+#include <atomic>
+
+/*
+ * There are three copies of T. The writer owns one, the reader owns one, and the third is the
+ * most recently published one. Publishing and acquiring swap an index with the shared copy, so
+ * neither side can block the other. The reader always gets the newest value; versions that were
+ * published in between are skipped.
+ *
+ * There must be exactly one writer thread and one reader thread. The write buffer holds stale
+ * data after publish(), so the writer has to fill in all of it before each publish().
+ */
+template <typename T>
+class TripleBuffer {
+public:
+  TripleBuffer() : buffers(), shared(1), write_index(0), read_index(2) {}
+
+  // Writer side.
+  T& getWriteBuffer() { return buffers[write_index]; }
+  void publish() {
+    int previous = shared.exchange(write_index | NEW_DATA, std::memory_order_acq_rel);
+    write_index = previous & INDEX_MASK;
+  }
+
+  // Reader side. Returns true if something was published since the last call.
+  bool acquireLatest() {
+    if((shared.load(std::memory_order_relaxed) & NEW_DATA) == 0) {
+      return false;
+    }
+    int previous = shared.exchange(read_index, std::memory_order_acq_rel);
+    read_index = previous & INDEX_MASK;
+    return true;
+  }
+  const T& getReadBuffer() const { return buffers[read_index]; }
+
+private:
+  static const int INDEX_MASK = 3;
+  static const int NEW_DATA = 4;
+
+  T buffers[3];
+  std::atomic<int> shared;  // Index of the shared buffer, plus NEW_DATA if the reader hasn't seen it.
+  int write_index;
+  int read_index;
+
+  TripleBuffer(const TripleBuffer&) = delete;
+  TripleBuffer& operator=(const TripleBuffer&) = delete;
+};
+
+#endif  // TRIPLEBUFFER_H_INCLUDED